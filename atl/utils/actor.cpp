@@ -0,0 +1,10 @@
+#include "atl/utils/actor.h"
+
+namespace atl {
+
+uint64_t NextActorIndex() {
+    static std::atomic<uint64_t> index(0);
+    return index.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "atl/utils/slab_allocator.h"
+#include "atl/utils/thread_pool2.h"
+
+namespace atl {
+
+// 为新建的Actor分配分片, 按创建顺序轮流分配
+uint64_t NextActorIndex();
+
+/**
+ * @brief 运行在ThreadPool2上的Actor
+ *
+ * 每个Actor有一个侵入式的多生产者单消费者邮箱, 消息节点从SlabAllocator分配.
+ * 邮箱由空变为非空时, Actor才被提交到它所属的分片上执行, 每次执行最多处理batch_size条消息,
+ * 还有剩余消息时重新提交, 让同一分片上的其他Actor有机会执行.
+ * 同一个Actor的消息按发送顺序串行处理, 处理函数可以不加锁地访问状态.
+ * 销毁Actor之前必须保证没有待处理的消息, 例如在线程池Stop/Wait之后销毁
+ *
+ * 用法:
+ *     atl::Actor<Session, Request> actor(pool, Session(), [](Session& session, Request& request) { ... });
+ *     actor.Send(Request());
+ */
+template<class State, class Msg>
+class Actor {
+public:
+    using Handler = std::function<void(State&, Msg&)>;
+
+public:
+    Actor(ThreadPool2& pool, State state, Handler handler, uint32_t batch_size = 64)
+        : pool_(pool)
+        , shard_(NextActorIndex())
+        , batch_size_(batch_size)
+        , state_(std::move(state))
+        , handler_(std::move(handler))
+        , pending_(0)
+        , head_(&stub_)
+        , tail_(&stub_) {}
+
+    Actor(const Actor&) = delete;
+    Actor& operator=(const Actor&) = delete;
+
+    ~Actor() {
+        while (Node* node = Pop()) {
+            delete node;
+        }
+    }
+
+    void Send(Msg msg) {
+        Push(new Node(std::move(msg)));
+        if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            Schedule();
+        }
+    }
+
+    // 邮箱中尚未处理的消息数量
+    size_t Pending() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    struct NodeBase {
+        std::atomic<NodeBase*> next;
+
+        NodeBase() : next(nullptr) {}
+    };
+
+    struct Node : NodeBase, SlabObject {
+        Msg msg;
+
+        explicit Node(Msg&& m) : msg(std::move(m)) {}
+    };
+
+    static constexpr int kLinkWaitRounds = 64;
+
+    void Schedule() {
+        pool_.Execute(shard_, [this]() { Run(); });
+    }
+
+    void Run() {
+        uint64_t processed = 0;
+        while (processed < batch_size_) {
+            Node* node = Pop();
+            if (node == nullptr) {
+                // 计数中还有消息说明生产者已经交换了head_但还没有链接好节点, 先让出线程等待链接完成,
+                // 仍然没有链接好时才重新提交, 避免立即重新提交在线程池上空转
+                if (pending_.load(std::memory_order_acquire) == processed || (node = WaitForLink()) == nullptr) {
+                    break;
+                }
+            }
+            handler_(state_, node->msg);
+            delete node;
+            processed++;
+        }
+        if (pending_.fetch_sub(processed, std::memory_order_acq_rel) != processed) {
+            Schedule();
+        }
+    }
+
+    Node* WaitForLink() {
+        for (int i = 0; i < kLinkWaitRounds; i++) {
+            std::this_thread::yield();
+            if (Node* node = Pop()) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    // Vyukov侵入式MPSC队列
+    void Push(NodeBase* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        NodeBase* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    Node* Pop() {
+        NodeBase* tail = tail_;
+        NodeBase* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<Node*>(tail);
+        }
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        Push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<Node*>(tail);
+        }
+        return nullptr;
+    }
+
+private:
+    ThreadPool2& pool_;
+    uint64_t shard_;
+    uint32_t batch_size_;
+    State state_;
+    Handler handler_;
+    std::atomic<uint64_t> pending_;
+    std::atomic<NodeBase*> head_;
+    NodeBase* tail_;
+    NodeBase stub_;
+};
+
+}
@@ -0,0 +1,78 @@
+#include "atl/utils/admission_controller.h"
+
+namespace atl {
+
+namespace {
+
+int64_t ToNanoseconds(AdmissionController::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+}
+
+AdmissionController::AdmissionController(Clock::duration target, Clock::duration interval)
+    : target_(ToNanoseconds(target))
+    , interval_(ToNanoseconds(interval))
+    , first_above_time_(0)
+    , overloaded_(false)
+    , rejected_(0)
+    , shed_(0)
+    , overloads_(0) {}
+
+bool AdmissionController::Admit(TaskPriority priority) {
+    if (priority != TaskPriority::kLow || !overloaded_.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool AdmissionController::OnDequeue(Clock::time_point enqueue_time, Clock::time_point now, TaskPriority priority) {
+    int64_t sojourn = ToNanoseconds(now - enqueue_time);
+    if (sojourn < target_) {
+        Recover();
+        return false;
+    }
+    int64_t current = ToNanoseconds(now.time_since_epoch());
+    int64_t first_above_time = first_above_time_.load(std::memory_order_relaxed);
+    if (first_above_time == 0) {
+        first_above_time_.compare_exchange_strong(first_above_time, current + interval_,
+                                                  std::memory_order_relaxed);
+        return false;
+    }
+    if (current < first_above_time) {
+        return false;
+    }
+    if (!overloaded_.load(std::memory_order_relaxed) && !overloaded_.exchange(true, std::memory_order_relaxed)) {
+        overloads_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (priority != TaskPriority::kLow) {
+        return false;
+    }
+    shed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void AdmissionController::OnIdle() {
+    Recover();
+}
+
+AdmissionController::Stats AdmissionController::GetStats() const {
+    Stats stats;
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.shed = shed_.load(std::memory_order_relaxed);
+    stats.overloads = overloads_.load(std::memory_order_relaxed);
+    stats.overloaded = overloaded_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AdmissionController::Recover() {
+    if (first_above_time_.load(std::memory_order_relaxed) != 0) {
+        first_above_time_.store(0, std::memory_order_relaxed);
+    }
+    if (overloaded_.load(std::memory_order_relaxed)) {
+        overloaded_.store(false, std::memory_order_relaxed);
+    }
+}
+
+}
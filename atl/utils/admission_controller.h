@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace atl {
+
+enum class TaskPriority {
+    // 过载时可以被拒绝或丢弃
+    kLow,
+    kNormal,
+};
+
+/**
+ * @brief 按排队时间(sojourn time)判断过载的准入控制, 思路来自CoDel
+ *
+ * 每个任务出队时上报它的排队时间. 排队时间持续一个interval都高于target时进入过载状态,
+ * 过载期间新提交的低优先级任务被拒绝, 已排队且排队时间超过target的低优先级任务被丢弃.
+ * 出现一次低于target的排队时间, 或工作线程空闲时, 退出过载状态.
+ * 默认参数与CoDel相同, 一般不需要调整
+ */
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        // 提交时被拒绝的任务数
+        size_t rejected;
+        // 出队时被丢弃的任务数
+        size_t shed;
+        // 进入过载状态的次数
+        size_t overloads;
+        bool overloaded;
+    };
+
+public:
+    explicit AdmissionController(Clock::duration target = std::chrono::milliseconds(5),
+                                 Clock::duration interval = std::chrono::milliseconds(100));
+
+    // 提交时调用, 返回false表示拒绝
+    bool Admit(TaskPriority priority);
+    // 出队时调用, 返回true表示丢弃该任务
+    bool OnDequeue(Clock::time_point enqueue_time, Clock::time_point now, TaskPriority priority);
+    // 工作线程没有任务可执行时调用
+    void OnIdle();
+
+    bool IsOverloaded() const { return overloaded_.load(std::memory_order_relaxed); }
+    Stats GetStats() const;
+
+private:
+    void Recover();
+
+private:
+    const int64_t target_;
+    const int64_t interval_;
+    // 排队时间第一次高于target之后再过interval的时刻, 0表示当前排队时间低于target
+    std::atomic<int64_t> first_above_time_;
+    std::atomic<bool> overloaded_;
+    std::atomic<size_t> rejected_;
+    std::atomic<size_t> shed_;
+    std::atomic<size_t> overloads_;
+};
+
+}
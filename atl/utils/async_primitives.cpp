@@ -0,0 +1,156 @@
+#include "atl/utils/async_primitives.h"
+
+namespace atl {
+
+AsyncSemaphore::AsyncSemaphore(Executor& executor, size_t count)
+    : executor_(executor)
+    , count_(count) {}
+
+void AsyncSemaphore::Acquire(std::function<void()>&& continuation) {
+    if (AcquireOrEnqueue(continuation)) {
+        continuation();
+    }
+}
+
+bool AsyncSemaphore::TryAcquire() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (count_ == 0) {
+        return false;
+    }
+    count_--;
+    return true;
+}
+
+bool AsyncSemaphore::AcquireOrEnqueue(std::function<void()>& continuation) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (count_ > 0) {
+        count_--;
+        return true;
+    }
+    waiters_.push_back(std::move(continuation));
+    return false;
+}
+
+void AsyncSemaphore::Release(size_t count) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        // 许可直接转交给等待者, 不经过count_, 避免新来的请求插队
+        while (count > 0 && !waiters_.empty()) {
+            ready.push_back(std::move(waiters_.front()));
+            waiters_.pop_front();
+            count--;
+        }
+        count_ += count;
+    }
+    for (auto& continuation : ready) {
+        executor_.Execute(std::move(continuation));
+    }
+}
+
+size_t AsyncSemaphore::Available() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return count_;
+}
+
+AsyncMutex::AsyncMutex(Executor& executor)
+    : semaphore_(executor, 1) {}
+
+void AsyncMutex::Lock(std::function<void()>&& continuation) {
+    semaphore_.Acquire(std::move(continuation));
+}
+
+bool AsyncMutex::TryLock() {
+    return semaphore_.TryAcquire();
+}
+
+void AsyncMutex::Unlock() {
+    semaphore_.Release(1);
+}
+
+Latch::Latch(Executor& executor, size_t count)
+    : executor_(executor)
+    , count_(count) {}
+
+void Latch::CountDown(size_t count) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (count_ == 0) {
+            return;
+        }
+        count_ = count >= count_ ? 0 : count_ - count;
+        if (count_ == 0) {
+            ready.swap(waiters_);
+        }
+    }
+    for (auto& continuation : ready) {
+        executor_.Execute(std::move(continuation));
+    }
+}
+
+void Latch::Wait(std::function<void()>&& continuation) {
+    if (ReadyOrEnqueue(continuation)) {
+        continuation();
+    }
+}
+
+bool Latch::TryWait() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return count_ == 0;
+}
+
+bool Latch::ReadyOrEnqueue(std::function<void()>& continuation) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (count_ == 0) {
+        return true;
+    }
+    waiters_.push_back(std::move(continuation));
+    return false;
+}
+
+Barrier::Barrier(Executor& executor, size_t count, std::function<void()>&& completion)
+    : executor_(executor)
+    , count_(count)
+    , remaining_(count)
+    , completion_(std::move(completion)) {}
+
+void Barrier::ArriveAndWait(std::function<void()>&& continuation) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        waiters_.push_back(std::move(continuation));
+        ready = Arrive();
+    }
+    for (auto& waiter : ready) {
+        executor_.Execute(std::move(waiter));
+    }
+}
+
+void Barrier::ArriveAndDrop() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        count_--;
+        ready = Arrive();
+    }
+    for (auto& waiter : ready) {
+        executor_.Execute(std::move(waiter));
+    }
+}
+
+std::vector<std::function<void()>> Barrier::Arrive() {
+    std::vector<std::function<void()>> ready;
+    if (--remaining_ > 0) {
+        return ready;
+    }
+    // 最后一个到达者执行completion, 执行期间不会有下一轮的到达者
+    if (completion_) {
+        completion_();
+    }
+    remaining_ = count_;
+    ready.swap(waiters_);
+    return ready;
+}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ATL_HAS_COROUTINE 1
+#endif
+
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+/**
+ * 本文件中的同步原语不会阻塞线程. 无法立即满足的请求把后续操作(回调函数或协程)放入等待队列,
+ * 条件满足时由释放方把后续操作提交到构造时指定的执行器, 而不是唤醒一个被挂起的线程.
+ * 可以立即满足的请求直接在调用线程上执行后续操作.
+ * 在C++20下还提供co_await接口
+ */
+
+class AsyncSemaphore {
+public:
+    AsyncSemaphore(Executor& executor, size_t count);
+
+    AsyncSemaphore(const AsyncSemaphore&) = delete;
+    AsyncSemaphore& operator=(const AsyncSemaphore&) = delete;
+
+    // 获取一个许可后执行continuation
+    void Acquire(std::function<void()>&& continuation);
+    bool TryAcquire();
+    void Release(size_t count = 1);
+    size_t Available();
+
+#ifdef ATL_HAS_COROUTINE
+    auto AcquireAsync() {
+        struct Awaiter {
+            AsyncSemaphore& semaphore;
+            bool await_ready() { return semaphore.TryAcquire(); }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                std::function<void()> continuation = [handle]() { handle.resume(); };
+                return !semaphore.AcquireOrEnqueue(continuation);
+            }
+            void await_resume() {}
+        };
+        return Awaiter{*this};
+    }
+#endif
+
+private:
+    // 立即获取到许可时返回true且不移动continuation, 否则放入等待队列
+    bool AcquireOrEnqueue(std::function<void()>& continuation);
+
+private:
+    Executor& executor_;
+    std::mutex mtx_;
+    size_t count_;
+    std::deque<std::function<void()>> waiters_;
+};
+
+class AsyncMutex {
+public:
+    explicit AsyncMutex(Executor& executor);
+
+    // 获取锁后执行continuation, continuation负责调用Unlock
+    void Lock(std::function<void()>&& continuation);
+    bool TryLock();
+    void Unlock();
+
+#ifdef ATL_HAS_COROUTINE
+    auto LockAsync() { return semaphore_.AcquireAsync(); }
+#endif
+
+private:
+    AsyncSemaphore semaphore_;
+};
+
+/**
+ * @brief 一次性的倒计数器, 计数减到0时所有等待者被提交到执行器
+ */
+class Latch {
+public:
+    Latch(Executor& executor, size_t count);
+
+    Latch(const Latch&) = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    void CountDown(size_t count = 1);
+    void Wait(std::function<void()>&& continuation);
+    bool TryWait();
+
+#ifdef ATL_HAS_COROUTINE
+    auto WaitAsync() {
+        struct Awaiter {
+            Latch& latch;
+            bool await_ready() { return latch.TryWait(); }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                std::function<void()> continuation = [handle]() { handle.resume(); };
+                return !latch.ReadyOrEnqueue(continuation);
+            }
+            void await_resume() {}
+        };
+        return Awaiter{*this};
+    }
+#endif
+
+private:
+    bool ReadyOrEnqueue(std::function<void()>& continuation);
+
+private:
+    Executor& executor_;
+    std::mutex mtx_;
+    size_t count_;
+    std::vector<std::function<void()>> waiters_;
+};
+
+/**
+ * @brief 可重复使用的屏障, 每一轮所有参与者到达后执行completion, 然后把本轮所有等待者提交到执行器
+ */
+class Barrier {
+public:
+    Barrier(Executor& executor, size_t count, std::function<void()>&& completion = nullptr);
+
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+
+    void ArriveAndWait(std::function<void()>&& continuation);
+    // 到达后退出, 之后的每一轮参与者数量减一
+    void ArriveAndDrop();
+
+#ifdef ATL_HAS_COROUTINE
+    auto ArriveAndWaitAsync() {
+        struct Awaiter {
+            Barrier& barrier;
+            bool await_ready() { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                barrier.ArriveAndWait([handle]() { handle.resume(); });
+            }
+            void await_resume() {}
+        };
+        return Awaiter{*this};
+    }
+#endif
+
+private:
+    // 调用前必须持有mtx_, 返回本轮需要提交的等待者
+    std::vector<std::function<void()>> Arrive();
+
+private:
+    Executor& executor_;
+    std::mutex mtx_;
+    size_t count_;
+    size_t remaining_;
+    std::function<void()> completion_;
+    std::vector<std::function<void()>> waiters_;
+};
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "atl/utils/thread_pool.h"
+
+namespace atl {
+
+template<class T>
+class AsyncResultGroup;
+
+/**
+ * @brief 按缓存行隔开的结果槽位的只读视图, 只在回调函数执行期间有效
+ */
+template<class T>
+class ResultSpan {
+private:
+    struct alignas(64) Slot {
+        T value;
+    };
+
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        explicit Iterator(const Slot* slot) : slot_(slot) {}
+        const T& operator*() const { return slot_->value; }
+        const T* operator->() const { return &slot_->value; }
+        Iterator& operator++() { ++slot_; return *this; }
+        bool operator==(const Iterator& other) const { return slot_ == other.slot_; }
+        bool operator!=(const Iterator& other) const { return slot_ != other.slot_; }
+
+    private:
+        const Slot* slot_;
+    };
+
+public:
+    ResultSpan(const Slot* slots, size_t size) : slots_(slots), size_(size) {}
+    size_t Size() const { return size_; }
+    const T& operator[](size_t index) const { return slots_[index].value; }
+    Iterator begin() const { return Iterator(slots_); }
+    Iterator end() const { return Iterator(slots_ + size_); }
+
+private:
+    friend class AsyncResultGroup<T>;
+
+    const Slot* slots_;
+    size_t size_;
+};
+
+/**
+ * @brief 收集返回值的任务分组
+ *
+ * 每个任务的返回值写入预先分配的, 按缓存行隔开的槽位, 任务之间不需要加锁.
+ * 所有任务完成后, 完成回调收到全部结果. 设置了归约函数时, 任务完成后在线程池内按二叉树两两归约,
+ * 后完成的一方负责合并, 归约结果在分组完成回调之前交给归约回调.
+ *
+ * 用法:
+ *     atl::AsyncResultGroup<int> group([](atl::ResultSpan<int> results) { ... });
+ *     group.Push([]() { return 1; });
+ *     pool.Push(group.CreateAsyncGroup());
+ */
+template<class T>
+class AsyncResultGroup {
+public:
+    using Slot = typename ResultSpan<T>::Slot;
+    using FinishCallback = std::function<void(ResultSpan<T>)>;
+    using Reducer = std::function<T(const T&, const T&)>;
+    using ReduceCallback = std::function<void(T&)>;
+
+public:
+    explicit AsyncResultGroup(FinishCallback&& finish_callback = nullptr)
+        : state_(std::make_shared<State>()) {
+        state_->finish_callback = std::move(finish_callback);
+    }
+
+    void Push(std::function<T()>&& async_function) {
+        state_->functions.emplace_back(std::move(async_function));
+    }
+
+    void SetReducer(Reducer&& reducer, ReduceCallback&& reduce_callback) {
+        state_->reducer = std::move(reducer);
+        state_->reduce_callback = std::move(reduce_callback);
+    }
+
+    /**
+     * @brief 分配结果槽位并生成可以提交给ThreadPool/ThreadPool2的AsyncGroup,
+     *        调用后本对象不再持有任何任务
+     */
+    AsyncGroup* CreateAsyncGroup() {
+        std::shared_ptr<State> state = std::move(state_);
+        state_ = std::make_shared<State>();
+
+        size_t count = state->functions.size();
+        state->slots.resize(count);
+        if (state->reducer) {
+            state->partials.resize(count);
+            for (size_t width = (count + 1) / 2; count > 1; width = (width + 1) / 2) {
+                state->arrivals.emplace_back(new std::atomic<int>[width]);
+                for (size_t i = 0; i < width; i++) {
+                    state->arrivals.back()[i].store(0, std::memory_order_relaxed);
+                }
+                if (width == 1) {
+                    break;
+                }
+            }
+        }
+
+        AsyncGroup* group = ThreadPool::CreateAsyncGroup([state]() {
+            if (state->finish_callback) {
+                state->finish_callback(ResultSpan<T>(state->slots.data(), state->slots.size()));
+            }
+        });
+        for (size_t i = 0; i < count; i++) {
+            group->Push([state, i]() {
+                state->slots[i].value = state->functions[i]();
+                if (state->reducer) {
+                    state->partials[i].value = state->slots[i].value;
+                    Reduce(*state, i);
+                }
+            });
+        }
+        return group;
+    }
+
+private:
+    struct State {
+        std::vector<std::function<T()>> functions;
+        std::vector<Slot> slots;
+        FinishCallback finish_callback;
+        Reducer reducer;
+        ReduceCallback reduce_callback;
+        // 归约的中间结果, 每棵子树的结果存放在其最左侧叶子对应的位置
+        std::vector<Slot> partials;
+        // 每一层内部节点的到达计数, 第二个到达的任务负责合并左右子树
+        std::vector<std::unique_ptr<std::atomic<int>[]>> arrivals;
+    };
+
+    static void Reduce(State& state, size_t leaf) {
+        size_t index = leaf;
+        size_t width = state.slots.size();
+        for (size_t level = 0; width > 1; level++) {
+            size_t sibling = index ^ 1;
+            if (sibling < width) {
+                if (state.arrivals[level][index >> 1].fetch_add(1, std::memory_order_acq_rel) == 0) {
+                    return;
+                }
+                size_t left = (index & ~static_cast<size_t>(1)) << level;
+                size_t right = (index | 1) << level;
+                state.partials[left].value = state.reducer(state.partials[left].value,
+                                                           state.partials[right].value);
+            }
+            index >>= 1;
+            width = (width + 1) / 2;
+        }
+        if (state.reduce_callback) {
+            state.reduce_callback(state.partials[0].value);
+        }
+    }
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+}
@@ -0,0 +1,45 @@
+#include "atl/utils/batcher.h"
+
+namespace atl {
+
+uint64_t NextBatcherId() {
+    static std::atomic<uint64_t> next_id(1);
+    return next_id.fetch_add(1);
+}
+
+BatcherMetrics::BatcherMetrics()
+    : items_(0)
+    , batches_(0) {
+    for (auto& reason : reasons_) {
+        reason.store(0);
+    }
+    for (auto& bucket : histogram_) {
+        bucket.store(0);
+    }
+}
+
+void BatcherMetrics::Record(size_t batch_size, BatchFlushReason reason) {
+    int bucket = 0;
+    while (bucket + 1 < BatcherStats::kBuckets && (batch_size >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    items_.fetch_add(batch_size, std::memory_order_relaxed);
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    reasons_[static_cast<int>(reason)].fetch_add(1, std::memory_order_relaxed);
+    histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+BatcherStats BatcherMetrics::Snapshot() const {
+    BatcherStats stats;
+    stats.items = items_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.size_flushes = reasons_[static_cast<int>(BatchFlushReason::kSize)].load(std::memory_order_relaxed);
+    stats.timer_flushes = reasons_[static_cast<int>(BatchFlushReason::kTimer)].load(std::memory_order_relaxed);
+    stats.manual_flushes = reasons_[static_cast<int>(BatchFlushReason::kManual)].load(std::memory_order_relaxed);
+    for (int i = 0; i < BatcherStats::kBuckets; i++) {
+        stats.histogram[i] = histogram_[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+}
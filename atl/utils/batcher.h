@@ -0,0 +1,272 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/timer_queue.h"
+
+namespace atl {
+
+enum class BatchFlushReason {
+    // 批次达到最大数量
+    kSize,
+    // 批次中最早的元素等待时间达到上限
+    kTimer,
+    // 调用Flush或析构
+    kManual,
+};
+
+struct BatcherStats {
+    static constexpr int kBuckets = 17;
+
+    uint64_t items;
+    uint64_t batches;
+    uint64_t size_flushes;
+    uint64_t timer_flushes;
+    uint64_t manual_flushes;
+    // 批次大小分布, histogram[i]为大小在[2^i, 2^(i+1))之间的批次数量, 最后一个桶包含更大的批次
+    uint64_t histogram[kBuckets];
+};
+
+class BatcherMetrics {
+public:
+    BatcherMetrics();
+    void Record(size_t batch_size, BatchFlushReason reason);
+    BatcherStats Snapshot() const;
+
+private:
+    std::atomic<uint64_t> items_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<uint64_t> reasons_[3];
+    std::atomic<uint64_t> histogram_[BatcherStats::kBuckets];
+};
+
+uint64_t NextBatcherId();
+
+/**
+ * @brief 把单个元素聚合成批次, 每个批次作为一个任务提交到线程池
+ *
+ * 每个生产者线程有自己的缓冲区, 缓冲区达到max_batch_size个元素, 或者其中最早的元素等待超过max_delay时,
+ * 缓冲区中的元素作为一个批次整体移交给线程池中的任务. 生产者之间互不竞争,
+ * 缓冲区上的自旋标志只会与定时刷新竞争.
+ * 超时刷新由TimerQueue::Default()驱动, 只在有缓冲区非空时才会设置定时器
+ */
+template<class T, class Pool = ThreadPool>
+class Batcher {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Handler = std::function<void(std::vector<T>&&)>;
+
+public:
+    Batcher(Pool& pool, size_t max_batch_size, std::chrono::microseconds max_delay, Handler&& handler)
+        : core_(std::make_shared<Core>(pool, max_batch_size, max_delay, std::move(handler))) {}
+
+    ~Batcher() {
+        Flush();
+        std::lock_guard<std::mutex> lock(core_->mtx);
+        if (core_->timer_id != 0) {
+            TimerQueue::Default().Cancel(core_->timer_id);
+        }
+    }
+
+    Batcher(const Batcher&) = delete;
+    Batcher& operator=(const Batcher&) = delete;
+
+    void Add(T&& item) {
+        ProducerBuffer* buffer = LocalBuffer();
+        std::vector<T> batch;
+        bool first_item = false;
+        buffer->Lock();
+        if (buffer->items.empty()) {
+            buffer->first_item_time = Clock::now();
+            first_item = true;
+        }
+        buffer->items.push_back(std::move(item));
+        if (buffer->items.size() >= core_->max_batch_size) {
+            batch.swap(buffer->items);
+            buffer->items.reserve(core_->max_batch_size);
+        }
+        buffer->Unlock();
+
+        if (!batch.empty()) {
+            Core::Submit(core_, std::move(batch), BatchFlushReason::kSize);
+        } else if (first_item) {
+            Core::ArmTimer(core_);
+        }
+    }
+
+    void Add(const T& item) {
+        T copy(item);
+        Add(std::move(copy));
+    }
+
+    // 立即提交所有生产者缓冲区中的元素
+    void Flush() {
+        Core::FlushBuffers(core_, BatchFlushReason::kManual, Clock::time_point::max());
+    }
+
+    BatcherStats GetStats() const {
+        return core_->metrics.Snapshot();
+    }
+
+private:
+    struct ProducerBuffer {
+        std::atomic<bool> busy{false};
+        std::vector<T> items;
+        Clock::time_point first_item_time;
+
+        void Lock() {
+            while (busy.exchange(true, std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        void Unlock() {
+            busy.store(false, std::memory_order_release);
+        }
+    };
+
+    struct Core {
+        Pool& pool;
+        size_t max_batch_size;
+        std::chrono::microseconds max_delay;
+        Handler handler;
+        uint64_t id;
+        BatcherMetrics metrics;
+        std::mutex mtx;
+        std::vector<std::unique_ptr<ProducerBuffer>> buffers;
+        std::atomic<bool> timer_armed;
+        uint64_t timer_id;
+
+        Core(Pool& pool, size_t max_batch_size, std::chrono::microseconds max_delay, Handler&& handler)
+            : pool(pool)
+            , max_batch_size(max_batch_size > 0 ? max_batch_size : 1)
+            , max_delay(max_delay)
+            , handler(std::move(handler))
+            , id(NextBatcherId())
+            , timer_armed(false)
+            , timer_id(0) {}
+
+        static void Submit(const std::shared_ptr<Core>& core, std::vector<T>&& batch, BatchFlushReason reason) {
+            core->metrics.Record(batch.size(), reason);
+            core->pool.Push([core, batch = std::move(batch)]() mutable { core->handler(std::move(batch)); },
+                            []() {});
+        }
+
+        // 提交first_item_time不晚于deadline的缓冲区, 返回剩余缓冲区中最早的first_item_time
+        static Clock::time_point FlushBuffers(const std::shared_ptr<Core>& core,
+                                              BatchFlushReason reason,
+                                              Clock::time_point deadline) {
+            Clock::time_point earliest = Clock::time_point::max();
+            std::vector<std::vector<T>> batches;
+            {
+                std::lock_guard<std::mutex> lock(core->mtx);
+                for (auto& buffer : core->buffers) {
+                    buffer->Lock();
+                    if (!buffer->items.empty()) {
+                        if (buffer->first_item_time <= deadline) {
+                            batches.emplace_back();
+                            batches.back().swap(buffer->items);
+                        } else if (buffer->first_item_time < earliest) {
+                            earliest = buffer->first_item_time;
+                        }
+                    }
+                    buffer->Unlock();
+                }
+            }
+            for (auto& batch : batches) {
+                Submit(core, std::move(batch), reason);
+            }
+            return earliest;
+        }
+
+        static void ArmTimer(const std::shared_ptr<Core>& core) {
+            if (core->timer_armed.exchange(true)) {
+                return;
+            }
+            ScheduleTimer(core, Clock::now() + core->max_delay);
+        }
+
+        static void ScheduleTimer(const std::shared_ptr<Core>& core, Clock::time_point when) {
+            std::weak_ptr<Core> weak_core = core;
+            std::lock_guard<std::mutex> lock(core->mtx);
+            core->timer_id = TimerQueue::Default().Schedule(when, [weak_core]() {
+                std::shared_ptr<Core> core = weak_core.lock();
+                if (core) {
+                    OnTimer(core);
+                }
+            });
+        }
+
+        static void OnTimer(const std::shared_ptr<Core>& core) {
+            Clock::time_point earliest = FlushBuffers(core, BatchFlushReason::kTimer, Clock::now() - core->max_delay);
+            if (earliest != Clock::time_point::max()) {
+                ScheduleTimer(core, earliest + core->max_delay);
+                return;
+            }
+            core->timer_armed.store(false);
+            // 取消定时器之后再检查一次, 避免生产者在此期间写入的元素因为定时器已设置而没有重新设置定时器
+            std::lock_guard<std::mutex> lock(core->mtx);
+            core->timer_id = 0;
+            for (auto& buffer : core->buffers) {
+                buffer->Lock();
+                bool pending = !buffer->items.empty();
+                buffer->Unlock();
+                if (pending && !core->timer_armed.exchange(true)) {
+                    std::weak_ptr<Core> weak_core = core;
+                    core->timer_id = TimerQueue::Default().Schedule(core->max_delay, [weak_core]() {
+                        std::shared_ptr<Core> core = weak_core.lock();
+                        if (core) {
+                            OnTimer(core);
+                        }
+                    });
+                    break;
+                }
+            }
+        }
+    };
+
+private:
+    struct LocalEntry {
+        ProducerBuffer* buffer;
+        // 缓冲区归Core所有, Core销毁后这一项在下次注册新缓冲区时删除
+        std::weak_ptr<Core> core;
+    };
+
+    ProducerBuffer* LocalBuffer() {
+        // 以batcher的唯一id为键, 每个生产者线程只在第一次写入时加锁注册缓冲区
+        thread_local std::unordered_map<uint64_t, LocalEntry> local_buffers;
+        auto iter = local_buffers.find(core_->id);
+        if (iter != local_buffers.end()) {
+            return iter->second.buffer;
+        }
+        // 长期存在的生产者线程会用到很多先后销毁的batcher, 注册时顺便清理已经销毁的
+        for (auto it = local_buffers.begin(); it != local_buffers.end();) {
+            if (it->second.core.expired()) {
+                it = local_buffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        std::unique_ptr<ProducerBuffer> buffer(new ProducerBuffer());
+        buffer->items.reserve(core_->max_batch_size);
+        ProducerBuffer* result = buffer.get();
+        {
+            std::lock_guard<std::mutex> lock(core_->mtx);
+            core_->buffers.push_back(std::move(buffer));
+        }
+        local_buffers.emplace(core_->id, LocalEntry{result, core_});
+        return result;
+    }
+
+private:
+    std::shared_ptr<Core> core_;
+};
+
+}
@@ -0,0 +1,83 @@
+#include "atl/utils/blocking_pool.h"
+
+#include <thread>
+
+namespace atl {
+
+BlockingPool::BlockingPool(size_t max_threads, std::chrono::milliseconds keep_alive)
+    : state_(std::make_shared<State>()) {
+    state_->max_threads = max_threads > 0 ? max_threads : 1;
+    state_->keep_alive = keep_alive;
+}
+
+BlockingPool::~BlockingPool() {
+    Stop();
+    Wait();
+}
+
+void BlockingPool::Execute(std::function<void()>&& task) {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    if (state_->stopped) {
+        return;
+    }
+    state_->tasks.push_back(std::move(task));
+    // 排队的任务比空闲线程多时才创建新线程
+    if (state_->tasks.size() > state_->idle_count && state_->thread_count < state_->max_threads) {
+        state_->thread_count++;
+        std::thread(&BlockingPool::WorkThread, state_).detach();
+    } else {
+        state_->cv.notify_one();
+    }
+}
+
+void BlockingPool::Stop() {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    state_->stopped = true;
+    state_->tasks.clear();
+    state_->cv.notify_all();
+}
+
+void BlockingPool::Wait() {
+    std::unique_lock<std::mutex> lock(state_->mtx);
+    state_->exit_cv.wait(lock, [this]() { return state_->thread_count == 0; });
+}
+
+size_t BlockingPool::ThreadCount() {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->thread_count;
+}
+
+size_t BlockingPool::IdleCount() {
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->idle_count;
+}
+
+void BlockingPool::WorkThread(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> lock(state->mtx);
+    while (true) {
+        if (!state->tasks.empty()) {
+            std::function<void()> task = std::move(state->tasks.front());
+            state->tasks.pop_front();
+            lock.unlock();
+            task();
+            task = nullptr;
+            lock.lock();
+            continue;
+        }
+        if (state->stopped) {
+            break;
+        }
+        state->idle_count++;
+        bool timeout = !state->cv.wait_for(lock, state->keep_alive, [&state]() {
+            return !state->tasks.empty() || state->stopped;
+        });
+        state->idle_count--;
+        if (timeout) {
+            break;
+        }
+    }
+    state->thread_count--;
+    state->exit_cv.notify_all();
+}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+/**
+ * @brief 执行阻塞任务的弹性线程池
+ *
+ * 没有空闲线程时为新任务创建线程, 线程数达到max_threads后任务排队等待.
+ * 空闲超过keep_alive的线程自动退出, 平时不占用线程.
+ * 用于执行阻塞的系统调用或长时间持有锁的任务, 避免占用ThreadPool的计算线程
+ */
+class BlockingPool : public Executor {
+public:
+    explicit BlockingPool(size_t max_threads = 256,
+                          std::chrono::milliseconds keep_alive = std::chrono::seconds(10));
+    ~BlockingPool() override;
+
+    BlockingPool(const BlockingPool&) = delete;
+    BlockingPool& operator=(const BlockingPool&) = delete;
+
+    void Execute(std::function<void()>&& task) override;
+
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> Push(AsyncFunctionType&& async_function) {
+        using result_type = typename std::result_of<AsyncFunctionType()>::type;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(
+            std::forward<AsyncFunctionType>(async_function));
+        std::future<result_type> future = task->get_future();
+        Execute([task]() { (*task)(); });
+        return future;
+    }
+
+    // 丢弃排队中的任务, 之后提交的任务也会被丢弃, 正在执行的任务不受影响
+    void Stop();
+    // 等待所有线程退出, 必须在Stop之后调用
+    void Wait();
+
+    size_t ThreadCount();
+    size_t IdleCount();
+
+private:
+    // 线程是分离的, 共享状态由线程和线程池共同持有, 线程退出时不会访问已销毁的线程池
+    struct State {
+        size_t max_threads;
+        std::chrono::milliseconds keep_alive;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::condition_variable exit_cv;
+        std::deque<std::function<void()>> tasks;
+        size_t thread_count = 0;
+        size_t idle_count = 0;
+        bool stopped = false;
+    };
+
+    static void WorkThread(std::shared_ptr<State> state);
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+}
@@ -0,0 +1,25 @@
+#include "atl/utils/cancellation.h"
+
+namespace atl {
+
+CancellationToken::CancellationToken() noexcept {}
+
+CancellationToken::CancellationToken(const std::shared_ptr<State>& state)
+    : state_(state) {}
+
+CancellationSource::CancellationSource()
+    : state_(std::make_shared<CancellationToken::State>()) {}
+
+void CancellationSource::Cancel() {
+    state_->cancelled.store(true, std::memory_order_release);
+}
+
+bool CancellationSource::IsCancellationRequested() const {
+    return state_->cancelled.load(std::memory_order_acquire);
+}
+
+CancellationToken CancellationSource::Token() const {
+    return CancellationToken(state_);
+}
+
+}
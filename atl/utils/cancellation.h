@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace atl {
+
+class CancellationSource;
+
+/**
+ * @brief 取消令牌, 由CancellationSource生成, 只能查询是否已被取消
+ *
+ * 默认构造的令牌不关联任何CancellationSource, 永远不会被取消
+ */
+class CancellationToken {
+public:
+    CancellationToken() noexcept;
+
+    /**
+     * @brief 关联的CancellationSource是否已调用Cancel
+     *
+     * 正在运行的任务可以周期性地调用此函数, 以便尽早退出
+     */
+    bool IsCancellationRequested() const {
+        return state_ && state_->cancelled.load(std::memory_order_acquire);
+    }
+    bool CanBeCancelled() const { return static_cast<bool>(state_); }
+
+private:
+    friend class CancellationSource;
+
+    struct State {
+        std::atomic<bool> cancelled;
+
+        State() : cancelled(false) {}
+    };
+
+    explicit CancellationToken(const std::shared_ptr<State>& state);
+
+private:
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief 取消源, 调用Cancel后, 所有由Token()生成的令牌都处于取消状态
+ */
+class CancellationSource {
+public:
+    CancellationSource();
+
+    void Cancel();
+    bool IsCancellationRequested() const;
+    CancellationToken Token() const;
+
+private:
+    std::shared_ptr<CancellationToken::State> state_;
+};
+
+}
@@ -0,0 +1,26 @@
+#include "atl/utils/channel.h"
+
+namespace atl {
+
+Select::Select()
+    : state_(std::make_shared<SelectState>()) {}
+
+Select& Select::OnDefault(std::function<void()>&& callback) {
+    default_callback_ = std::move(callback);
+    return *this;
+}
+
+void Select::Run() {
+    // 有默认分支时只检查各通道是否就绪, 不在任何通道上等待
+    bool wait = !default_callback_;
+    for (auto& select_case : cases_) {
+        if (state_->fired.load(std::memory_order_acquire) || select_case(state_, wait)) {
+            return;
+        }
+    }
+    if (!wait && state_->Claim()) {
+        default_callback_();
+    }
+}
+
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "atl/utils/async_primitives.h"
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+// 一次Select的共享状态, 所有分支中只有第一个抢到fired的分支会被执行
+struct SelectState {
+    std::atomic<bool> fired{false};
+
+    bool Claim() { return !fired.exchange(true, std::memory_order_acq_rel); }
+};
+
+/**
+ * @brief Go风格的有界多生产者多消费者通道
+ *
+ * capacity为0时是无缓冲通道, 发送方在接收方取走数据后才算完成.
+ * 发送和接收都不阻塞线程: 无法立即完成的请求把回调函数放入等待队列, 由对端完成时提交到执行器;
+ * 可以立即完成的请求直接在调用线程上执行回调函数.
+ * 关闭后不能再发送, 缓冲区中剩余的数据仍然可以接收, 取完后接收方收到std::nullopt
+ */
+template<class T>
+class Channel {
+public:
+    using ReceiveCallback = std::function<void(std::optional<T>)>;
+    using SendCallback = std::function<void(bool)>;
+
+public:
+    Channel(Executor& executor, size_t capacity)
+        : executor_(executor)
+        , capacity_(capacity)
+        , closed_(false) {}
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    /**
+     * @brief 发送数据, 数据进入缓冲区或被接收方取走后调用callback(true), 通道已关闭时调用callback(false)
+     */
+    void Send(T value, SendCallback&& callback = nullptr) {
+        std::optional<bool> result = SendOrEnqueue(value, callback);
+        if (result && callback) {
+            callback(*result);
+        }
+    }
+
+    bool TrySend(T& value) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (closed_) {
+            return false;
+        }
+        if (DeliverToReceiver(value, lock)) {
+            return true;
+        }
+        if (buffer_.size() < capacity_) {
+            buffer_.push_back(std::move(value));
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 接收数据, 通道已关闭且没有剩余数据时callback收到std::nullopt
+     */
+    void Receive(ReceiveCallback&& callback) {
+        std::optional<T> value;
+        if (ReceiveOrEnqueue(nullptr, value, callback)) {
+            callback(std::move(value));
+        }
+    }
+
+    bool TryReceive(T& value) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        std::optional<T> result;
+        if (!TakeValue(result, lock)) {
+            return false;
+        }
+        value = std::move(*result);
+        return true;
+    }
+
+    void Close() {
+        std::deque<std::shared_ptr<Receiver>> receivers;
+        std::deque<Sender> senders;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (closed_) {
+                return;
+            }
+            closed_ = true;
+            receivers.swap(receivers_);
+            senders.swap(senders_);
+        }
+        for (auto& receiver : receivers) {
+            if (!receiver->select || receiver->select->Claim()) {
+                auto callback = std::make_shared<ReceiveCallback>(std::move(receiver->callback));
+                executor_.Execute([callback]() { (*callback)(std::nullopt); });
+            }
+        }
+        for (auto& sender : senders) {
+            if (sender.callback) {
+                auto callback = std::make_shared<SendCallback>(std::move(sender.callback));
+                executor_.Execute([callback]() { (*callback)(false); });
+            }
+        }
+    }
+
+    bool IsClosed() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return closed_;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return buffer_.size();
+    }
+
+#ifdef ATL_HAS_COROUTINE
+    auto ReceiveAsync() {
+        struct Awaiter {
+            Channel& channel;
+            std::optional<T> result;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                ReceiveCallback callback = [this, handle](std::optional<T> value) {
+                    result = std::move(value);
+                    handle.resume();
+                };
+                return !channel.ReceiveOrEnqueue(nullptr, result, callback);
+            }
+            std::optional<T> await_resume() { return std::move(result); }
+        };
+        return Awaiter{*this, std::nullopt};
+    }
+
+    auto SendAsync(T value) {
+        struct Awaiter {
+            Channel& channel;
+            T value;
+            bool result;
+
+            bool await_ready() { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                SendCallback callback = [this, handle](bool sent) {
+                    result = sent;
+                    handle.resume();
+                };
+                std::optional<bool> sent = channel.SendOrEnqueue(value, callback);
+                if (sent) {
+                    result = *sent;
+                    return false;
+                }
+                return true;
+            }
+            bool await_resume() { return result; }
+        };
+        return Awaiter{*this, std::move(value), false};
+    }
+#endif
+
+private:
+    friend class Select;
+
+    struct Receiver {
+        std::shared_ptr<SelectState> select;
+        ReceiveCallback callback;
+    };
+
+    struct Sender {
+        T value;
+        SendCallback callback;
+    };
+
+    // 立即完成时返回结果, 否则放入等待队列并返回std::nullopt
+    std::optional<bool> SendOrEnqueue(T& value, SendCallback& callback) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (closed_) {
+            return false;
+        }
+        if (DeliverToReceiver(value, lock)) {
+            return true;
+        }
+        if (buffer_.size() < capacity_) {
+            buffer_.push_back(std::move(value));
+            return true;
+        }
+        senders_.push_back(Sender{std::move(value), std::move(callback)});
+        return std::nullopt;
+    }
+
+    // 把数据直接交给第一个仍然有效的等待者, 调用前必须持有锁, 成功时会释放锁
+    bool DeliverToReceiver(T& value, std::unique_lock<std::mutex>& lock) {
+        while (!receivers_.empty()) {
+            std::shared_ptr<Receiver> receiver = std::move(receivers_.front());
+            receivers_.pop_front();
+            // Select的其他分支已经执行, 跳过
+            if (receiver->select && !receiver->select->Claim()) {
+                continue;
+            }
+            lock.unlock();
+            auto delivery = std::make_shared<std::optional<T>>(std::move(value));
+            executor_.Execute([receiver, delivery]() { receiver->callback(std::move(*delivery)); });
+            return true;
+        }
+        return false;
+    }
+
+    // 从缓冲区或等待中的发送方取出数据, 调用前必须持有锁, 成功时会释放锁
+    bool TakeValue(std::optional<T>& value, std::unique_lock<std::mutex>& lock) {
+        std::shared_ptr<SendCallback> sender_callback;
+        if (!buffer_.empty()) {
+            value = std::move(buffer_.front());
+            buffer_.pop_front();
+            // 缓冲区空出位置, 第一个等待中的发送方完成
+            if (!senders_.empty()) {
+                buffer_.push_back(std::move(senders_.front().value));
+                sender_callback = std::make_shared<SendCallback>(std::move(senders_.front().callback));
+                senders_.pop_front();
+            }
+        } else if (!senders_.empty()) {
+            value = std::move(senders_.front().value);
+            sender_callback = std::make_shared<SendCallback>(std::move(senders_.front().callback));
+            senders_.pop_front();
+        } else {
+            return false;
+        }
+        lock.unlock();
+        if (sender_callback && *sender_callback) {
+            executor_.Execute([sender_callback]() { (*sender_callback)(true); });
+        }
+        return true;
+    }
+
+    // 立即完成(取到数据或通道已关闭)时返回true且不移动callback, 否则在wait为true时放入等待队列
+    bool ReceiveOrEnqueue(const std::shared_ptr<SelectState>& select,
+                          std::optional<T>& value,
+                          ReceiveCallback& callback,
+                          bool wait = true) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        bool ready = !buffer_.empty() || !senders_.empty() || closed_;
+        if (ready && select && !select->Claim()) {
+            // Select的其他分支已经执行, 当前分支既不取数据也不等待
+            return false;
+        }
+        if (TakeValue(value, lock)) {
+            return true;
+        }
+        if (closed_) {
+            return true;
+        }
+        if (!wait) {
+            return false;
+        }
+        receivers_.push_back(std::make_shared<Receiver>(Receiver{select, std::move(callback)}));
+        return false;
+    }
+
+private:
+    Executor& executor_;
+    size_t capacity_;
+    std::mutex mtx_;
+    bool closed_;
+    std::deque<T> buffer_;
+    std::deque<std::shared_ptr<Receiver>> receivers_;
+    std::deque<Sender> senders_;
+};
+
+/**
+ * @brief 同时等待多个通道, 只有最先就绪的一个分支会被执行
+ *
+ * 用法:
+ *     atl::Select()
+ *         .OnReceive(ch1, [](std::optional<int> value) { ... })
+ *         .OnReceive(ch2, [](std::optional<std::string> value) { ... })
+ *         .Run();
+ * 设置了OnDefault时, 如果没有分支可以立即执行, 则执行默认分支而不等待
+ */
+class Select {
+public:
+    Select();
+
+    template<class T>
+    Select& OnReceive(Channel<T>& channel, typename Channel<T>::ReceiveCallback&& callback) {
+        auto shared_callback = std::make_shared<typename Channel<T>::ReceiveCallback>(std::move(callback));
+        cases_.push_back([&channel, shared_callback](const std::shared_ptr<SelectState>& state, bool wait) {
+            std::optional<T> value;
+            typename Channel<T>::ReceiveCallback callback = *shared_callback;
+            if (channel.ReceiveOrEnqueue(state, value, callback, wait)) {
+                callback(std::move(value));
+                return true;
+            }
+            return false;
+        });
+        return *this;
+    }
+
+    Select& OnDefault(std::function<void()>&& callback);
+
+    /**
+     * @brief 执行Select, 每个Select对象只能执行一次
+     */
+    void Run();
+
+private:
+    std::shared_ptr<SelectState> state_;
+    std::vector<std::function<bool(const std::shared_ptr<SelectState>&, bool)>> cases_;
+    std::function<void()> default_callback_;
+};
+
+}
@@ -0,0 +1,15 @@
+#include "atl/utils/child_task.h"
+
+#include <thread>
+
+namespace atl {
+
+void HelpWait(ThreadPool& pool, const std::atomic<int>& pending) {
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!pool.RunPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}
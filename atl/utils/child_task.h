@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <utility>
+
+#include "atl/utils/thread_pool.h"
+
+namespace atl {
+
+/**
+ * @brief ForkJoinGroup和TaskScope共用的子任务节点, 以ThreadPool::PushNode提交
+ *
+ * Group需要提供ShouldRun(), Fail(std::exception_ptr), Arrive()和静态函数Release(Node*).
+ * ShouldRun返回false时跳过任务函数, 任务函数抛出的异常交给Fail.
+ * 执行或被丢弃后先由Release回收节点, 再调用Arrive, Arrive之后节点和Group都可能已经销毁
+ */
+template<class Group, class FunctionType>
+class ChildTask final : public TaskNode {
+public:
+    template<class F>
+    ChildTask(Group* group, F&& func)
+        : group_(group)
+        , func_(std::forward<F>(func)) {}
+
+private:
+    void Run() override {
+        Group* group = group_;
+        if (group->ShouldRun()) {
+            try {
+                func_();
+            } catch (...) {
+                group->Fail(std::current_exception());
+            }
+        }
+        Group::Release(this);
+        group->Arrive();
+    }
+
+    void Discard() override {
+        Group* group = group_;
+        Group::Release(this);
+        group->Arrive();
+    }
+
+private:
+    Group* group_;
+    FunctionType func_;
+};
+
+// 等待pending归零, 期间通过RunPendingTask帮助执行等待中的任务, 没有可执行的任务时让出CPU
+void HelpWait(ThreadPool& pool, const std::atomic<int>& pending);
+
+}
@@ -0,0 +1,247 @@
+#include "atl/utils/epoch.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace atl {
+
+namespace {
+
+// 每个线程攒够这么多对象才尝试推进纪元
+constexpr size_t kBatchSize = 64;
+
+struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t epoch;
+};
+
+// 每个线程一份, 线程退出后由新线程复用, 永不释放, 推进纪元时可以无锁遍历
+struct alignas(64) Record {
+    // 0表示不在保护区内, 否则为进入保护区或上次静止点时观察到的纪元
+    std::atomic<uint64_t> announced{0};
+    std::atomic<bool> in_use{true};
+    Record* next = nullptr;
+    // 以下只有所属线程访问, 统计值用load+store写入
+    int pin_depth = 0;
+    bool online = false;
+    std::vector<Retired> limbo;
+    std::atomic<uint64_t> retired{0};
+    std::atomic<uint64_t> reclaimed{0};
+};
+
+struct Domain {
+    // 从1开始, 0留给Record::announced表示不在保护区内
+    std::atomic<uint64_t> epoch{1};
+    std::atomic<Record*> records{nullptr};
+    // 退出的线程留下的还不能释放的对象
+    std::mutex orphan_mtx;
+    std::vector<Retired> orphans;
+    std::atomic<uint64_t> orphan_reclaimed{0};
+};
+
+Domain& GetDomain() {
+    static Domain* domain = new Domain();
+    return *domain;
+}
+
+void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+Record* AcquireRecord() {
+    Domain& domain = GetDomain();
+    for (Record* record = domain.records.load(); record != nullptr; record = record->next) {
+        bool expected = false;
+        if (!record->in_use.load(std::memory_order_relaxed) && record->in_use.compare_exchange_strong(expected, true)) {
+            return record;
+        }
+    }
+    Record* record = new Record();
+    record->next = domain.records.load();
+    while (!domain.records.compare_exchange_weak(record->next, record)) {
+    }
+    return record;
+}
+
+// 释放纪元足够旧的对象, 其余的保持原来的顺序, 返回释放的个数.
+// 先把到期的对象移出再调用deleter, deleter中可以继续调用Retire
+size_t FreeExpired(std::vector<Retired>& retired, uint64_t epoch) {
+    std::vector<Retired> expired;
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); i++) {
+        if (retired[i].epoch + 2 <= epoch) {
+            expired.push_back(retired[i]);
+        } else {
+            retired[kept++] = retired[i];
+        }
+    }
+    retired.resize(kept);
+    for (const Retired& item : expired) {
+        item.deleter(item.ptr);
+    }
+    return expired.size();
+}
+
+// 所有在保护区内的线程都观察到当前纪元时推进一个纪元, 返回推进后(或者没能推进时)的纪元
+uint64_t TryAdvance() {
+    Domain& domain = GetDomain();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = domain.epoch.load();
+    for (Record* record = domain.records.load(); record != nullptr; record = record->next) {
+        uint64_t announced = record->announced.load();
+        if (announced != 0 && announced != epoch) {
+            return epoch;
+        }
+    }
+    if (domain.epoch.compare_exchange_strong(epoch, epoch + 1)) {
+        epoch++;
+    }
+    std::unique_lock<std::mutex> lock(domain.orphan_mtx, std::try_to_lock);
+    if (lock.owns_lock() && !domain.orphans.empty()) {
+        std::vector<Retired> orphans;
+        orphans.swap(domain.orphans);
+        lock.unlock();
+        size_t count = FreeExpired(orphans, epoch);
+        domain.orphan_reclaimed.fetch_add(count, std::memory_order_relaxed);
+        lock.lock();
+        domain.orphans.insert(domain.orphans.begin(), orphans.begin(), orphans.end());
+    }
+    return epoch;
+}
+
+class LocalRecord {
+public:
+    ~LocalRecord() {
+        if (record_ == nullptr) {
+            return;
+        }
+        record_->announced.store(0);
+        record_->online = false;
+        record_->pin_depth = 0;
+        if (!record_->limbo.empty()) {
+            Add(record_->reclaimed, FreeExpired(record_->limbo, TryAdvance()));
+            Domain& domain = GetDomain();
+            std::lock_guard<std::mutex> lock(domain.orphan_mtx);
+            domain.orphans.insert(domain.orphans.end(), record_->limbo.begin(), record_->limbo.end());
+            record_->limbo.clear();
+        }
+        record_->in_use.store(false);
+        // 之后在线程本地对象析构过程中调用Retire会重新申请一个记录, 不会用到已经交还的记录
+        record_ = nullptr;
+    }
+
+    Record* Get() {
+        if (record_ == nullptr) {
+            record_ = AcquireRecord();
+        }
+        return record_;
+    }
+
+private:
+    Record* record_ = nullptr;
+};
+
+thread_local LocalRecord local_record;
+
+void Collect(Record* record) {
+    Add(record->reclaimed, FreeExpired(record->limbo, TryAdvance()));
+}
+
+// 公告之后的全屏障保证之后读取受保护的指针不会被重排到公告之前
+void Announce(Record* record, uint64_t epoch) {
+    record->announced.store(epoch, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+}
+
+EpochGuard::EpochGuard()
+    : counted_(false) {
+    Record* record = local_record.Get();
+    if (record->online) {
+        return;
+    }
+    counted_ = true;
+    if (record->pin_depth++ == 0) {
+        Announce(record, GetDomain().epoch.load(std::memory_order_relaxed));
+    }
+}
+
+EpochGuard::~EpochGuard() {
+    if (!counted_) {
+        return;
+    }
+    Record* record = local_record.Get();
+    if (--record->pin_depth == 0 && !record->online) {
+        record->announced.store(0, std::memory_order_release);
+    }
+}
+
+namespace epoch {
+
+void Retire(void* ptr, void (*deleter)(void*)) {
+    Record* record = local_record.Get();
+    record->limbo.push_back(Retired{ptr, deleter, GetDomain().epoch.load()});
+    Add(record->retired, 1);
+    if (record->limbo.size() >= kBatchSize) {
+        Collect(record);
+    }
+}
+
+void Online() {
+    Record* record = local_record.Get();
+    record->online = true;
+    Announce(record, GetDomain().epoch.load(std::memory_order_relaxed));
+}
+
+void Offline() {
+    Record* record = local_record.Get();
+    record->online = false;
+    record->announced.store(record->pin_depth > 0 ? GetDomain().epoch.load() : 0);
+    if (!record->limbo.empty()) {
+        Collect(record);
+    }
+}
+
+void QuiescentState() {
+    Record* record = local_record.Get();
+    if (!record->online) {
+        return;
+    }
+    uint64_t epoch = GetDomain().epoch.load(std::memory_order_acquire);
+    if (record->announced.load(std::memory_order_relaxed) == epoch) {
+        return;
+    }
+    Announce(record, epoch);
+    if (!record->limbo.empty()) {
+        Add(record->reclaimed, FreeExpired(record->limbo, epoch));
+    }
+}
+
+void Flush() {
+    Record* record = local_record.Get();
+    while (!record->limbo.empty()) {
+        QuiescentState();
+        Collect(record);
+        if (!record->limbo.empty()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+Stats GetStats() {
+    Domain& domain = GetDomain();
+    Stats stats{domain.epoch.load(), 0, domain.orphan_reclaimed.load(std::memory_order_relaxed)};
+    for (Record* record = domain.records.load(); record != nullptr; record = record->next) {
+        stats.retired += record->retired.load(std::memory_order_relaxed);
+        stats.reclaimed += record->reclaimed.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+}
+
+}
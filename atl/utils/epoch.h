@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+namespace atl {
+
+/**
+ * @brief 基于纪元的内存回收, 用于无锁数据结构中从结构上摘除的节点
+ *
+ * 摘除节点后调用epoch::Retire, 节点在所有可能持有它的线程都经过静止点之后才被释放.
+ * 线程池的工作线程处于在线状态, 任务之间自动报告静止点, 休眠前转为离线, 所以任务内可以直接访问受保护的指针.
+ * 其他线程访问前需要构造EpochGuard. 延迟释放的节点按线程攒批, 每攒够一批才尝试推进纪元并释放.
+ * 受保护的指针不能跨越任务边界保存, 也不能跨越纤程的切换点
+ *
+ * 用法:
+ *     Node* old = head.exchange(replacement);
+ *     atl::epoch::Retire(old);
+ */
+class EpochGuard {
+public:
+    // 当前线程在线或已经在保护区内时什么都不做
+    EpochGuard();
+    ~EpochGuard();
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+private:
+    // 在线线程上构造的EpochGuard不计入嵌套深度
+    bool counted_;
+};
+
+namespace epoch {
+
+struct Stats {
+    // 当前纪元
+    uint64_t epoch;
+    // 累计延迟释放的对象数
+    uint64_t retired;
+    // 累计已经释放的对象数
+    uint64_t reclaimed;
+};
+
+// 对象在当前纪元之后两个纪元才会被释放, deleter在某个调用Retire或推进纪元的线程上执行
+void Retire(void* ptr, void (*deleter)(void*));
+
+template<class T>
+void Retire(T* ptr) {
+    Retire(static_cast<void*>(ptr), [](void* p) { delete static_cast<T*>(p); });
+}
+
+// 长期运行的线程可以进入在线状态, 此后不需要EpochGuard, 但必须定期调用QuiescentState, 否则会阻止回收.
+// 线程池的工作线程由线程池负责调用
+void Online();
+void Offline();
+// 调用时当前线程不能持有任何受保护的指针. 纪元没有变化时只有一次原子读
+void QuiescentState();
+
+// 推进纪元直到当前线程延迟释放的对象全部释放, 期间等待其他在线线程经过静止点. 调用线程不能持有受保护的指针
+void Flush();
+Stats GetStats();
+
+}
+
+}
@@ -0,0 +1,668 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/thread_pool2.h"
+
+/**
+ * P2300(std::execution)风格的sender/receiver, 只依赖C++17, 名字与P2300保持一致
+ *
+ * sender: 有value_types(std::tuple<值类型...>)和connect(receiver)成员, connect返回operation state
+ * receiver: 有set_value(值...), set_error(std::exception_ptr)和set_stopped()成员
+ * operation state: 不可复制和移动, 有start()成员, 从start到receiver收到结果期间必须保持有效
+ * 错误统一以std::exception_ptr传递, 不支持停止令牌.
+ * 所有operation state都不分配内存, 提交到线程池的任务节点直接存放在operation state中
+ *
+ * 用法:
+ *     atl::execution::Scheduler scheduler(pool);
+ *     auto sender = atl::execution::schedule(scheduler)
+ *                 | atl::execution::then([]() { return 21; })
+ *                 | atl::execution::then([](int value) { return value * 2; });
+ *     std::optional<std::tuple<int>> result = atl::execution::sync_wait(std::move(sender));
+ */
+namespace atl {
+namespace execution {
+
+struct sender_t {};
+struct receiver_t {};
+struct operation_state_t {};
+struct scheduler_t {};
+
+template<class Sender, class Receiver>
+using ConnectResult = decltype(std::declval<Sender>().connect(std::declval<Receiver>()));
+
+template<class Pool, class Receiver>
+class ScheduleOperation : public TaskNode {
+public:
+    using operation_state_concept = operation_state_t;
+
+    template<class R>
+    ScheduleOperation(Pool* pool, R&& receiver)
+        : pool_(pool)
+        , receiver_(std::forward<R>(receiver)) {}
+
+    ScheduleOperation(const ScheduleOperation&) = delete;
+    ScheduleOperation& operator=(const ScheduleOperation&) = delete;
+
+    void start() noexcept { pool_->PushNode(this); }
+
+private:
+    void Run() override { receiver_.set_value(); }
+    // 线程池已停止
+    void Discard() override { receiver_.set_stopped(); }
+
+private:
+    Pool* pool_;
+    Receiver receiver_;
+};
+
+/**
+ * @brief ThreadPool/ThreadPool2的调度器, schedule()返回的sender在线程池的工作线程上完成
+ */
+template<class Pool>
+class Scheduler {
+public:
+    using scheduler_concept = scheduler_t;
+
+    class ScheduleSender {
+    public:
+        using sender_concept = sender_t;
+        using value_types = std::tuple<>;
+
+        explicit ScheduleSender(Pool* pool) : pool_(pool) {}
+
+        template<class Receiver>
+        ScheduleOperation<Pool, std::decay_t<Receiver>> connect(Receiver&& receiver) const {
+            return ScheduleOperation<Pool, std::decay_t<Receiver>>(pool_, std::forward<Receiver>(receiver));
+        }
+
+        Scheduler get_completion_scheduler() const { return Scheduler(*pool_); }
+
+    private:
+        Pool* pool_;
+    };
+
+public:
+    explicit Scheduler(Pool& pool) : pool_(&pool) {}
+
+    ScheduleSender schedule() const { return ScheduleSender(pool_); }
+    // bulk最多拆分成的并行块数
+    size_t Concurrency() const { return pool_->Size(); }
+    void Submit(TaskNode* node) const { pool_->PushNode(node); }
+
+    bool operator==(const Scheduler& other) const { return pool_ == other.pool_; }
+    bool operator!=(const Scheduler& other) const { return pool_ != other.pool_; }
+
+private:
+    Pool* pool_;
+};
+
+// 在调用线程上直接执行, 用于不知道完成在哪个线程池上的sender
+class InlineScheduler {
+public:
+    size_t Concurrency() const { return 1; }
+    void Submit(TaskNode* node) const { node->Run(); }
+    bool operator==(const InlineScheduler&) const { return true; }
+    bool operator!=(const InlineScheduler&) const { return false; }
+};
+
+template<class Sender, class = void>
+struct CompletionScheduler {
+    using type = InlineScheduler;
+    static type Get(const Sender&) { return InlineScheduler(); }
+};
+
+template<class Sender>
+struct CompletionScheduler<Sender, std::void_t<decltype(std::declval<const Sender&>().get_completion_scheduler())>> {
+    using type = decltype(std::declval<const Sender&>().get_completion_scheduler());
+    static type Get(const Sender& sender) { return sender.get_completion_scheduler(); }
+};
+
+template<class Scheduler>
+auto schedule(const Scheduler& scheduler) {
+    return scheduler.schedule();
+}
+
+template<class Receiver, class... Values>
+class JustOperation {
+public:
+    using operation_state_concept = operation_state_t;
+
+    template<class R, class Tuple>
+    JustOperation(R&& receiver, Tuple&& values)
+        : receiver_(std::forward<R>(receiver))
+        , values_(std::forward<Tuple>(values)) {}
+
+    JustOperation(const JustOperation&) = delete;
+    JustOperation& operator=(const JustOperation&) = delete;
+
+    void start() noexcept {
+        std::apply([this](Values&... values) { receiver_.set_value(std::move(values)...); }, values_);
+    }
+
+private:
+    Receiver receiver_;
+    std::tuple<Values...> values_;
+};
+
+template<class... Values>
+class JustSender {
+public:
+    using sender_concept = sender_t;
+    using value_types = std::tuple<Values...>;
+
+    explicit JustSender(Values... values) : values_(std::move(values)...) {}
+
+    template<class Receiver>
+    JustOperation<std::decay_t<Receiver>, Values...> connect(Receiver&& receiver) && {
+        return JustOperation<std::decay_t<Receiver>, Values...>(std::forward<Receiver>(receiver), std::move(values_));
+    }
+
+private:
+    std::tuple<Values...> values_;
+};
+
+// 在调用start的线程上立即完成
+template<class... Values>
+JustSender<std::decay_t<Values>...> just(Values&&... values) {
+    return JustSender<std::decay_t<Values>...>(std::forward<Values>(values)...);
+}
+
+template<class Function, class Values>
+struct ThenValueTypes;
+
+template<class Function, class... Values>
+struct ThenValueTypes<Function, std::tuple<Values...>> {
+    using result_type = std::decay_t<std::invoke_result_t<Function&, Values...>>;
+    using type = std::conditional_t<std::is_void_v<result_type>, std::tuple<>, std::tuple<result_type>>;
+};
+
+template<class Receiver, class Function>
+class ThenReceiver {
+public:
+    using receiver_concept = receiver_t;
+
+    ThenReceiver(Receiver&& receiver, Function&& function)
+        : receiver_(std::move(receiver))
+        , function_(std::move(function)) {}
+
+    template<class... Values>
+    void set_value(Values&&... values) {
+        using Result = std::decay_t<std::invoke_result_t<Function&, Values...>>;
+        // 下游receiver抛出的异常不能再转成set_error, 所以只在try中调用function
+        if constexpr (std::is_void_v<Result>) {
+            try {
+                std::invoke(function_, std::forward<Values>(values)...);
+            } catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
+            }
+            receiver_.set_value();
+        } else {
+            std::optional<Result> result;
+            try {
+                result.emplace(std::invoke(function_, std::forward<Values>(values)...));
+            } catch (...) {
+                receiver_.set_error(std::current_exception());
+                return;
+            }
+            receiver_.set_value(std::move(*result));
+        }
+    }
+
+    void set_error(std::exception_ptr error) { receiver_.set_error(std::move(error)); }
+    void set_stopped() { receiver_.set_stopped(); }
+
+private:
+    Receiver receiver_;
+    Function function_;
+};
+
+template<class Sender, class Function>
+class ThenSender {
+public:
+    using sender_concept = sender_t;
+    using value_types = typename ThenValueTypes<Function, typename Sender::value_types>::type;
+
+    ThenSender(Sender&& sender, Function&& function)
+        : sender_(std::move(sender))
+        , function_(std::move(function)) {}
+
+    template<class Receiver>
+    auto connect(Receiver&& receiver) && {
+        return std::move(sender_).connect(
+            ThenReceiver<std::decay_t<Receiver>, Function>(std::decay_t<Receiver>(std::forward<Receiver>(receiver)),
+                                                          std::move(function_)));
+    }
+
+    template<class S = Sender>
+    auto get_completion_scheduler() const -> decltype(std::declval<const S&>().get_completion_scheduler()) {
+        return sender_.get_completion_scheduler();
+    }
+
+private:
+    Sender sender_;
+    Function function_;
+};
+
+template<class Function>
+struct ThenClosure {
+    Function function;
+};
+
+// 用上游的值调用function, 把返回值交给下游
+template<class Sender, class Function>
+ThenSender<std::decay_t<Sender>, std::decay_t<Function>> then(Sender&& sender, Function&& function) {
+    return ThenSender<std::decay_t<Sender>, std::decay_t<Function>>(
+        std::decay_t<Sender>(std::forward<Sender>(sender)),
+        std::decay_t<Function>(std::forward<Function>(function)));
+}
+
+template<class Function>
+ThenClosure<std::decay_t<Function>> then(Function&& function) {
+    return ThenClosure<std::decay_t<Function>>{std::forward<Function>(function)};
+}
+
+template<class Sender, class Function>
+auto operator|(Sender&& sender, ThenClosure<Function> closure) {
+    return then(std::forward<Sender>(sender), std::move(closure.function));
+}
+
+template<class Sender, class Shape, class Function, class Receiver, class Values = typename Sender::value_types>
+class BulkOperation;
+
+/**
+ * @brief 上游在线程池上完成时, 把[0, shape)切成不超过工作线程数的连续块, 第一块在当前线程执行,
+ *        其余块作为存放在operation state中的任务节点提交到线程池
+ */
+template<class Sender, class Shape, class Function, class Receiver, class... Values>
+class BulkOperation<Sender, Shape, Function, Receiver, std::tuple<Values...>> {
+public:
+    using operation_state_concept = operation_state_t;
+
+    static constexpr size_t kMaxChunks = 32;
+
+    template<class R>
+    BulkOperation(Sender&& sender, Shape shape, Function&& function, R&& receiver)
+        : receiver_(std::forward<R>(receiver))
+        , function_(std::move(function))
+        , shape_(shape)
+        , scheduler_(CompletionScheduler<Sender>::Get(sender))
+        , chunk_count_(0)
+        , remaining_(0)
+        , failed_(false)
+        , stopped_(false)
+        , child_(std::move(sender).connect(ValueReceiver{this})) {}
+
+    BulkOperation(const BulkOperation&) = delete;
+    BulkOperation& operator=(const BulkOperation&) = delete;
+
+    void start() noexcept { child_.start(); }
+
+private:
+    struct ValueReceiver {
+        using receiver_concept = receiver_t;
+
+        BulkOperation* op;
+
+        template<class... Args>
+        void set_value(Args&&... args) {
+            op->values_.emplace(std::forward<Args>(args)...);
+            op->Dispatch();
+        }
+        void set_error(std::exception_ptr error) { op->receiver_.set_error(std::move(error)); }
+        void set_stopped() { op->receiver_.set_stopped(); }
+    };
+
+    class Chunk : public TaskNode {
+    public:
+        BulkOperation* op = nullptr;
+        size_t index = 0;
+
+    private:
+        void Run() override { op->RunChunk(index); }
+        void Discard() override {
+            op->stopped_.store(true);
+            op->Arrive();
+        }
+    };
+
+    void Dispatch() {
+        size_t shape = static_cast<size_t>(shape_);
+        if (shape == 0) {
+            Complete();
+            return;
+        }
+        chunk_count_ = std::min({shape, std::max<size_t>(scheduler_.Concurrency(), 1), kMaxChunks});
+        remaining_.store(chunk_count_);
+        for (size_t i = 1; i < chunk_count_; i++) {
+            chunks_[i].op = this;
+            chunks_[i].index = i;
+            scheduler_.Submit(&chunks_[i]);
+        }
+        RunChunk(0);
+    }
+
+    void RunChunk(size_t index) {
+        size_t shape = static_cast<size_t>(shape_);
+        size_t begin = shape * index / chunk_count_;
+        size_t end = shape * (index + 1) / chunk_count_;
+        try {
+            for (size_t i = begin; i < end; i++) {
+                std::apply([this, i](Values&... values) { function_(static_cast<Shape>(i), values...); }, *values_);
+            }
+        } catch (...) {
+            if (!failed_.exchange(true)) {
+                error_ = std::current_exception();
+            }
+        }
+        Arrive();
+    }
+
+    void Arrive() {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Complete();
+        }
+    }
+
+    void Complete() {
+        if (failed_.load()) {
+            receiver_.set_error(std::move(error_));
+        } else if (stopped_.load()) {
+            receiver_.set_stopped();
+        } else {
+            std::apply([this](Values&... values) { receiver_.set_value(std::move(values)...); }, *values_);
+        }
+    }
+
+private:
+    Receiver receiver_;
+    Function function_;
+    Shape shape_;
+    typename CompletionScheduler<Sender>::type scheduler_;
+    std::optional<std::tuple<Values...>> values_;
+    std::array<Chunk, kMaxChunks> chunks_;
+    size_t chunk_count_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> stopped_;
+    std::exception_ptr error_;
+    ConnectResult<Sender, ValueReceiver> child_;
+};
+
+template<class Sender, class Shape, class Function>
+class BulkSender {
+public:
+    using sender_concept = sender_t;
+    using value_types = typename Sender::value_types;
+
+    BulkSender(Sender&& sender, Shape shape, Function&& function)
+        : sender_(std::move(sender))
+        , shape_(shape)
+        , function_(std::move(function)) {}
+
+    template<class Receiver>
+    BulkOperation<Sender, Shape, Function, std::decay_t<Receiver>> connect(Receiver&& receiver) && {
+        return BulkOperation<Sender, Shape, Function, std::decay_t<Receiver>>(
+            std::move(sender_), shape_, std::move(function_), std::forward<Receiver>(receiver));
+    }
+
+    template<class S = Sender>
+    auto get_completion_scheduler() const -> decltype(std::declval<const S&>().get_completion_scheduler()) {
+        return sender_.get_completion_scheduler();
+    }
+
+private:
+    Sender sender_;
+    Shape shape_;
+    Function function_;
+};
+
+template<class Shape, class Function>
+struct BulkClosure {
+    Shape shape;
+    Function function;
+};
+
+/**
+ * @brief 对[0, shape)中的每个i调用function(i, 上游的值...), 全部完成后把上游的值原样交给下游
+ *
+ * 上游在ThreadPool/ThreadPool2上完成时并行执行, 否则在完成上游的线程上依次执行.
+ * function抛出异常时其余块仍会执行完, 下游收到第一个异常
+ */
+template<class Sender, class Shape, class Function>
+BulkSender<std::decay_t<Sender>, Shape, std::decay_t<Function>> bulk(Sender&& sender, Shape shape,
+                                                                    Function&& function) {
+    static_assert(std::is_integral_v<Shape>, "bulk shape must be integral");
+    return BulkSender<std::decay_t<Sender>, Shape, std::decay_t<Function>>(
+        std::decay_t<Sender>(std::forward<Sender>(sender)),
+        shape,
+        std::decay_t<Function>(std::forward<Function>(function)));
+}
+
+template<class Shape, class Function>
+BulkClosure<Shape, std::decay_t<Function>> bulk(Shape shape, Function&& function) {
+    return BulkClosure<Shape, std::decay_t<Function>>{shape, std::forward<Function>(function)};
+}
+
+template<class Sender, class Shape, class Function>
+auto operator|(Sender&& sender, BulkClosure<Shape, Function> closure) {
+    return bulk(std::forward<Sender>(sender), closure.shape, std::move(closure.function));
+}
+
+template<class Operation, size_t I>
+struct WhenAllReceiver {
+    using receiver_concept = receiver_t;
+
+    Operation* op;
+
+    template<class... Args>
+    void set_value(Args&&... args) {
+        op->template SetValue<I>(std::forward<Args>(args)...);
+    }
+    void set_error(std::exception_ptr error) { op->SetError(std::move(error)); }
+    void set_stopped() { op->SetStopped(); }
+};
+
+// 逐个在成员初始化中connect, 使不可移动的子operation state直接构造在最终位置上
+template<class Operation, size_t I, class... Senders>
+class WhenAllChildren;
+
+template<class Operation, size_t I>
+class WhenAllChildren<Operation, I> {
+public:
+    template<class Tuple>
+    WhenAllChildren(Operation*, Tuple&) {}
+    void Start() {}
+};
+
+template<class Operation, size_t I, class First, class... Rest>
+class WhenAllChildren<Operation, I, First, Rest...> {
+public:
+    template<class Tuple>
+    WhenAllChildren(Operation* op, Tuple& senders)
+        : child_(std::move(std::get<I>(senders)).connect(WhenAllReceiver<Operation, I>{op}))
+        , rest_(op, senders) {}
+
+    void Start() {
+        child_.start();
+        rest_.Start();
+    }
+
+private:
+    ConnectResult<First, WhenAllReceiver<Operation, I>> child_;
+    WhenAllChildren<Operation, I + 1, Rest...> rest_;
+};
+
+template<class Receiver, class... Senders>
+class WhenAllOperation {
+public:
+    using operation_state_concept = operation_state_t;
+
+    template<class R>
+    WhenAllOperation(std::tuple<Senders...>&& senders, R&& receiver)
+        : receiver_(std::forward<R>(receiver))
+        , remaining_(sizeof...(Senders))
+        , failed_(false)
+        , stopped_(false)
+        , children_(this, senders) {}
+
+    WhenAllOperation(const WhenAllOperation&) = delete;
+    WhenAllOperation& operator=(const WhenAllOperation&) = delete;
+
+    void start() noexcept {
+        if constexpr (sizeof...(Senders) == 0) {
+            receiver_.set_value();
+        } else {
+            children_.Start();
+        }
+    }
+
+private:
+    template<class Operation, size_t I>
+    friend struct WhenAllReceiver;
+
+    template<size_t I, class... Args>
+    void SetValue(Args&&... args) {
+        std::get<I>(values_).emplace(std::forward<Args>(args)...);
+        Arrive();
+    }
+
+    void SetError(std::exception_ptr error) {
+        if (!failed_.exchange(true)) {
+            error_ = std::move(error);
+        }
+        Arrive();
+    }
+
+    void SetStopped() {
+        stopped_.store(true);
+        Arrive();
+    }
+
+    void Arrive() {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if (failed_.load()) {
+            receiver_.set_error(std::move(error_));
+        } else if (stopped_.load()) {
+            receiver_.set_stopped();
+        } else {
+            Complete(std::index_sequence_for<Senders...>());
+        }
+    }
+
+    template<size_t... Is>
+    void Complete(std::index_sequence<Is...>) {
+        std::apply([this](auto&&... values) { receiver_.set_value(std::move(values)...); },
+                   std::tuple_cat(std::move(*std::get<Is>(values_))...));
+    }
+
+private:
+    Receiver receiver_;
+    std::tuple<std::optional<typename Senders::value_types>...> values_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_;
+    std::atomic<bool> stopped_;
+    std::exception_ptr error_;
+    WhenAllChildren<WhenAllOperation, 0, Senders...> children_;
+};
+
+template<class... Senders>
+class WhenAllSender {
+public:
+    using sender_concept = sender_t;
+    using value_types = decltype(std::tuple_cat(std::declval<typename Senders::value_types>()...));
+
+    explicit WhenAllSender(Senders&&... senders) : senders_(std::move(senders)...) {}
+
+    template<class Receiver>
+    WhenAllOperation<std::decay_t<Receiver>, Senders...> connect(Receiver&& receiver) && {
+        return WhenAllOperation<std::decay_t<Receiver>, Senders...>(std::move(senders_),
+                                                                   std::forward<Receiver>(receiver));
+    }
+
+private:
+    std::tuple<Senders...> senders_;
+};
+
+/**
+ * @brief 所有上游都完成后, 按顺序把各上游的值拼接起来交给下游, 在最后完成的上游所在的线程上完成
+ *
+ * 任一上游出错时下游收到第一个错误, 否则任一上游停止时下游停止. 出错时不会取消其他上游
+ */
+template<class... Senders>
+WhenAllSender<std::decay_t<Senders>...> when_all(Senders&&... senders) {
+    return WhenAllSender<std::decay_t<Senders>...>(std::decay_t<Senders>(std::forward<Senders>(senders))...);
+}
+
+template<class Values>
+struct SyncWaitState {
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+    std::optional<Values> values;
+    std::exception_ptr error;
+};
+
+template<class Values>
+struct SyncWaitReceiver {
+    using receiver_concept = receiver_t;
+
+    SyncWaitState<Values>* state;
+
+    // 在锁内通知, 等待方返回并销毁状态之前通知已经完成
+    template<class... Args>
+    void set_value(Args&&... args) {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        state->values.emplace(std::forward<Args>(args)...);
+        state->done = true;
+        state->cv.notify_one();
+    }
+    void set_error(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        state->error = std::move(error);
+        state->done = true;
+        state->cv.notify_one();
+    }
+    void set_stopped() {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        state->done = true;
+        state->cv.notify_one();
+    }
+};
+
+/**
+ * @brief 启动sender并阻塞等待结果, 出错时重新抛出异常, 停止时返回std::nullopt
+ *
+ * 不能在sender要使用的线程池的工作线程上调用, 否则可能死锁
+ */
+template<class Sender>
+std::optional<typename Sender::value_types> sync_wait(Sender sender) {
+    using Values = typename Sender::value_types;
+    SyncWaitState<Values> state;
+    auto op = std::move(sender).connect(SyncWaitReceiver<Values>{&state});
+    op.start();
+    std::unique_lock<std::mutex> lock(state.mtx);
+    state.cv.wait(lock, [&state]() { return state.done; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
+    }
+    return std::move(state.values);
+}
+
+}
+}
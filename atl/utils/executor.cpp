@@ -0,0 +1,7 @@
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+Executor::~Executor() {}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <functional>
+
+namespace atl {
+
+/**
+ * @brief 任务执行器接口, ThreadPool/ThreadPool2以及各种适配器都实现了此接口,
+ *        用于在不关心具体线程池类型的组件中提交任务
+ */
+class Executor {
+public:
+    virtual ~Executor();
+    virtual void Execute(std::function<void()>&& task) = 0;
+};
+
+}
@@ -0,0 +1,480 @@
+#include "atl/utils/fiber.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/slab_allocator.h"
+#include "atl/utils/timer_queue.h"
+
+// 手写的切换函数使用ELF的汇编指示(.type/.size/.hidden)和不带下划线前缀的符号名, 其他目标文件格式(如Mach-O)使用ucontext
+#if !defined(ATL_FIBER_USE_UCONTEXT) && (!defined(__ELF__) || (!defined(__x86_64__) && !defined(__aarch64__)))
+#define ATL_FIBER_USE_UCONTEXT 1
+#endif
+
+#ifdef ATL_FIBER_USE_UCONTEXT
+// macOS只在定义了_XOPEN_SOURCE时提供已废弃的ucontext函数
+#if defined(__APPLE__) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600
+#endif
+#include <ucontext.h>
+#endif
+
+extern "C" void atl_fiber_entry();
+
+#ifndef ATL_FIBER_USE_UCONTEXT
+// 保存当前上下文的栈指针到*from_sp, 切换到to_sp保存的上下文.
+// 只保存被调用者保存的寄存器, 其余寄存器由编译器在调用点处理
+extern "C" void atl_fiber_switch(void** from_sp, void* to_sp);
+
+#if defined(__x86_64__)
+asm(R"(
+.text
+.globl atl_fiber_switch
+.hidden atl_fiber_switch
+.type atl_fiber_switch,@function
+.align 16
+atl_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+.size atl_fiber_switch,.-atl_fiber_switch
+)");
+#elif defined(__aarch64__)
+asm(R"(
+.text
+.global atl_fiber_switch
+.hidden atl_fiber_switch
+.type atl_fiber_switch,%function
+.align 4
+atl_fiber_switch:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x2, sp
+    str x2, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #176
+    ret
+.size atl_fiber_switch,.-atl_fiber_switch
+)");
+#endif
+#endif
+
+namespace atl {
+
+/**
+ * @brief 纤程栈池, 按块向系统申请栈内存, 释放的栈放回空闲列表复用, 不还给系统
+ */
+class FiberStackPool {
+public:
+    FiberStackPool(size_t stack_size, bool guard_page)
+        : page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+        , guard_size_(guard_page ? page_size_ : 0)
+        , reserved_bytes_(0) {
+        stack_size_ = (stack_size + page_size_ - 1) / page_size_ * page_size_;
+        if (stack_size_ == 0) {
+            stack_size_ = page_size_;
+        }
+    }
+
+    ~FiberStackPool() {
+        for (auto& chunk : chunks_) {
+            munmap(chunk.first, chunk.second);
+        }
+    }
+
+    size_t StackSize() const { return stack_size_; }
+
+    // 返回栈的最低可用地址
+    char* Allocate() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (free_stacks_.empty()) {
+            Reserve();
+        }
+        char* stack = free_stacks_.back();
+        free_stacks_.pop_back();
+        return stack;
+    }
+
+    void Free(char* stack) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        free_stacks_.push_back(stack);
+    }
+
+    size_t ReservedBytes() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return reserved_bytes_;
+    }
+
+private:
+    static constexpr size_t kStacksPerChunk = 16;
+
+    void Reserve() {
+        size_t slot_size = guard_size_ + stack_size_;
+        size_t chunk_size = slot_size * kStacksPerChunk;
+        void* chunk = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (chunk == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char* base = static_cast<char*>(chunk);
+        for (size_t i = 0; i < kStacksPerChunk; i++) {
+            char* slot = base + i * slot_size;
+            // 栈向低地址增长, 保护页放在最低处
+            if (guard_size_ > 0 && mprotect(slot, guard_size_, PROT_NONE) != 0) {
+                munmap(chunk, chunk_size);
+                throw std::bad_alloc();
+            }
+        }
+        for (size_t i = kStacksPerChunk; i > 0; i--) {
+            free_stacks_.push_back(base + (i - 1) * slot_size + guard_size_);
+        }
+        chunks_.emplace_back(chunk, chunk_size);
+        reserved_bytes_ += chunk_size;
+    }
+
+private:
+    const size_t page_size_;
+    const size_t guard_size_;
+    size_t stack_size_;
+    std::mutex mtx_;
+    std::vector<char*> free_stacks_;
+    std::vector<std::pair<void*, size_t>> chunks_;
+    size_t reserved_bytes_;
+};
+
+struct FiberRuntime;
+
+struct Fiber : public SlabObject {
+    struct Context {
+#ifdef ATL_FIBER_USE_UCONTEXT
+        ucontext_t uc;
+#else
+        void* sp = nullptr;
+#endif
+    };
+
+    Context context;
+    char* stack;
+    std::function<void()> function;
+    FiberScheduler* scheduler;
+    uint64_t shard;
+    // 最近一次恢复执行时所在线程的运行时, 由工作线程在切换进纤程前设置
+    FiberRuntime* runtime;
+};
+
+// 纤程切换回工作线程后由工作线程执行的动作, 保证纤程完全切换出去之后才可能被其他线程恢复
+enum class FiberAction {
+    kYield,
+    kPark,
+    kSleep,
+    kFinish,
+};
+
+struct FiberRuntime {
+    Fiber::Context scheduler_context;
+    Fiber* current = nullptr;
+    FiberAction action = FiberAction::kYield;
+    std::mutex* unlock = nullptr;
+    std::chrono::steady_clock::time_point wake_time;
+};
+
+namespace {
+
+thread_local FiberRuntime fiber_runtime;
+
+void SwitchContext(Fiber::Context* from, Fiber::Context* to) {
+#ifdef ATL_FIBER_USE_UCONTEXT
+    swapcontext(&from->uc, &to->uc);
+#else
+    atl_fiber_switch(&from->sp, to->sp);
+#endif
+}
+
+void InitContext(Fiber::Context* context, char* stack, size_t size) {
+#ifdef ATL_FIBER_USE_UCONTEXT
+    getcontext(&context->uc);
+    context->uc.uc_stack.ss_sp = stack;
+    context->uc.uc_stack.ss_size = size;
+    context->uc.uc_link = nullptr;
+    makecontext(&context->uc, atl_fiber_entry, 0);
+#elif defined(__x86_64__)
+    // 与atl_fiber_switch恢复的顺序一致: mxcsr/x87控制字, r15, r14, r13, r12, rbx, rbp, 返回地址.
+    // ret之后栈指针模16余8, 与普通函数入口一致
+    void** sp = reinterpret_cast<void**>(stack + size) - 9;
+    uint32_t mxcsr;
+    uint16_t fpu_control;
+    asm volatile("stmxcsr %0" : "=m"(mxcsr));
+    asm volatile("fnstcw %0" : "=m"(fpu_control));
+    uint64_t fpu_state = mxcsr | (static_cast<uint64_t>(fpu_control) << 32);
+    std::memcpy(&sp[0], &fpu_state, sizeof(fpu_state));
+    for (int i = 1; i <= 6; i++) {
+        sp[i] = nullptr;
+    }
+    sp[7] = reinterpret_cast<void*>(&atl_fiber_entry);
+    sp[8] = nullptr;
+    context->sp = sp;
+#elif defined(__aarch64__)
+    // x19-x30, d8-d15共176字节, x30(返回地址)位于偏移88
+    void** sp = reinterpret_cast<void**>(stack + size - 176);
+    std::memset(sp, 0, 176);
+    sp[11] = reinterpret_cast<void*>(&atl_fiber_entry);
+    context->sp = sp;
+#endif
+}
+
+// 切换回当前线程的调度上下文, 返回时可能已经在另一个线程上
+void SwitchOut(Fiber* self, FiberRuntime* runtime) {
+    SwitchContext(&self->context, &runtime->scheduler_context);
+}
+
+[[noreturn]] void FiberMain(Fiber* self) noexcept {
+    self->function();
+    self->function = nullptr;
+    FiberRuntime* runtime = self->runtime;
+    runtime->action = FiberAction::kFinish;
+    SwitchOut(self, runtime);
+    std::abort();
+}
+
+}
+
+FiberScheduler::FiberScheduler(ThreadPool2& pool, const FiberOptions& options)
+    : pool_(pool)
+    , options_(options)
+    , stacks_(new FiberStackPool(options.stack_size, options.guard_page))
+    , shard_count_(pool.Size() > 0 ? pool.Size() : 1)
+    , shard_load_(new std::atomic<int64_t>[shard_count_])
+    , next_shard_(0)
+    , live_count_(0)
+    , spawned_(0)
+    , finished_(0)
+    , switches_(0)
+    , migrations_(0) {
+    for (uint64_t i = 0; i < shard_count_; i++) {
+        shard_load_[i].store(0);
+    }
+}
+
+FiberScheduler::~FiberScheduler() {}
+
+void FiberScheduler::Spawn(std::function<void()>&& function) {
+    Fiber* fiber = new Fiber();
+    fiber->stack = stacks_->Allocate();
+    fiber->function = std::move(function);
+    fiber->scheduler = this;
+    fiber->shard = next_shard_.fetch_add(1, std::memory_order_relaxed) % shard_count_;
+    fiber->runtime = nullptr;
+    InitContext(&fiber->context, fiber->stack, stacks_->StackSize());
+    live_count_.fetch_add(1);
+    spawned_.fetch_add(1, std::memory_order_relaxed);
+    Schedule(fiber);
+}
+
+void FiberScheduler::Join() {
+    std::unique_lock<std::mutex> lock(join_mtx_);
+    join_cv_.wait(lock, [this]() { return live_count_.load() == 0; });
+}
+
+FiberScheduler::Stats FiberScheduler::GetStats() const {
+    Stats stats;
+    stats.spawned = spawned_.load(std::memory_order_relaxed);
+    stats.finished = finished_.load(std::memory_order_relaxed);
+    stats.switches = switches_.load(std::memory_order_relaxed);
+    stats.migrations = migrations_.load(std::memory_order_relaxed);
+    stats.stack_reserved_bytes = stacks_->ReservedBytes();
+    return stats;
+}
+
+void FiberScheduler::Schedule(Fiber* fiber) {
+    uint64_t shard = fiber->shard;
+    // 原分片还有排队的纤程时, 迁移到没有排队纤程的分片
+    if (shard_load_[shard].load(std::memory_order_relaxed) > 0) {
+        for (uint64_t i = 1; i < shard_count_; i++) {
+            uint64_t candidate = (shard + i) % shard_count_;
+            if (shard_load_[candidate].load(std::memory_order_relaxed) == 0) {
+                shard = candidate;
+                migrations_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+    fiber->shard = shard;
+    shard_load_[shard].fetch_add(1, std::memory_order_relaxed);
+    pool_.Execute(shard, [this, fiber]() { Resume(fiber); });
+}
+
+void FiberScheduler::Resume(Fiber* fiber) {
+    shard_load_[fiber->shard].fetch_sub(1, std::memory_order_relaxed);
+    switches_.fetch_add(1, std::memory_order_relaxed);
+    FiberRuntime* runtime = &fiber_runtime;
+    // 纤程内帮助执行任务时可能嵌套恢复另一个纤程, 保存外层的调度上下文
+    Fiber::Context outer_context = runtime->scheduler_context;
+    Fiber* outer_fiber = runtime->current;
+
+    runtime->current = fiber;
+    fiber->runtime = runtime;
+    SwitchContext(&runtime->scheduler_context, &fiber->context);
+
+    FiberAction action = runtime->action;
+    std::mutex* unlock = runtime->unlock;
+    std::chrono::steady_clock::time_point wake_time = runtime->wake_time;
+    runtime->current = outer_fiber;
+    runtime->scheduler_context = outer_context;
+    switch (action) {
+    case FiberAction::kYield:
+        // 经过分片的队列按提交顺序重新排队, 排在已经就绪的纤程之后, 不会进入工作线程的next_slot
+        Schedule(fiber);
+        break;
+    case FiberAction::kPark:
+        unlock->unlock();
+        break;
+    case FiberAction::kSleep:
+        TimerQueue::Default().Schedule(wake_time, [this, fiber]() { Schedule(fiber); });
+        break;
+    case FiberAction::kFinish:
+        Finish(fiber);
+        break;
+    }
+}
+
+void FiberScheduler::Finish(Fiber* fiber) {
+    stacks_->Free(fiber->stack);
+    delete fiber;
+    finished_.fetch_add(1, std::memory_order_relaxed);
+    if (live_count_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(join_mtx_);
+        join_cv_.notify_all();
+    }
+}
+
+FiberMutex::FiberMutex()
+    : locked_(false) {}
+
+void FiberMutex::Lock() {
+    FiberRuntime* runtime = &fiber_runtime;
+    Fiber* self = runtime->current;
+    if (self == nullptr) {
+        while (!TryLock()) {
+            std::this_thread::yield();
+        }
+        return;
+    }
+    mtx_.lock();
+    if (!locked_) {
+        locked_ = true;
+        mtx_.unlock();
+        return;
+    }
+    waiters_.push_back(self);
+    // 工作线程在纤程切换出去之后才释放mtx_, Unlock不会在切换完成前恢复这个纤程
+    runtime->action = FiberAction::kPark;
+    runtime->unlock = &mtx_;
+    SwitchOut(self, runtime);
+    // 被唤醒时锁已经转交给当前纤程
+}
+
+bool FiberMutex::TryLock() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (locked_) {
+        return false;
+    }
+    locked_ = true;
+    return true;
+}
+
+void FiberMutex::Unlock() {
+    Fiber* next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (waiters_.empty()) {
+            locked_ = false;
+        } else {
+            next = waiters_.front();
+            waiters_.pop_front();
+        }
+    }
+    if (next != nullptr) {
+        next->scheduler->Schedule(next);
+    }
+}
+
+namespace this_fiber {
+
+bool InFiber() {
+    return fiber_runtime.current != nullptr;
+}
+
+void Yield() {
+    FiberRuntime* runtime = &fiber_runtime;
+    Fiber* self = runtime->current;
+    if (self == nullptr) {
+        std::this_thread::yield();
+        return;
+    }
+    runtime->action = FiberAction::kYield;
+    SwitchOut(self, runtime);
+}
+
+void SleepFor(std::chrono::steady_clock::duration duration) {
+    FiberRuntime* runtime = &fiber_runtime;
+    Fiber* self = runtime->current;
+    if (self == nullptr) {
+        std::this_thread::sleep_for(duration);
+        return;
+    }
+    runtime->action = FiberAction::kSleep;
+    runtime->wake_time = std::chrono::steady_clock::now() + duration;
+    SwitchOut(self, runtime);
+}
+
+}
+
+}
+
+// 纤程第一次被恢复时从这里开始执行, 此时仍在恢复它的线程上, 可以读取线程本地的运行时
+extern "C" void atl_fiber_entry() {
+    atl::FiberMain(atl::fiber_runtime.current);
+}
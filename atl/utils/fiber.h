@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "atl/utils/thread_pool2.h"
+
+namespace atl {
+
+struct Fiber;
+class FiberStackPool;
+
+struct FiberOptions {
+    // 每个纤程的栈大小, 向上取整到页大小
+    size_t stack_size = 64 * 1024;
+    // 在栈底放置不可访问的保护页, 栈溢出时立即崩溃而不是破坏相邻内存, 适合调试.
+    // 每个保护页会多占用一个内存映射, 默认的vm.max_map_count(65530)下同时存在的纤程不能超过约3万个
+    bool guard_page = false;
+};
+
+/**
+ * @brief 运行在ThreadPool2上的M:N纤程调度器
+ *
+ * 纤程在用户态切换上下文(ELF平台的x86-64/aarch64使用手写汇编, 其他平台使用ucontext), 栈从池中分配并复用.
+ * 纤程可以调用this_fiber::Yield/SleepFor和FiberMutex, 等待期间不占用工作线程.
+ * 纤程被唤醒时优先回到上次运行的分片, 该分片还有排队的纤程而其他分片空闲时迁移到空闲分片.
+ * 纤程函数抛出的异常会导致std::terminate. 纤程可能在不同线程上恢复执行, 不能跨越切换点持有线程本地对象的引用.
+ * 调度器必须在所有纤程结束之后才能销毁, 可以用Join等待
+ *
+ * 用法:
+ *     atl::FiberScheduler scheduler(pool);
+ *     scheduler.Spawn([]() {
+ *         atl::this_fiber::SleepFor(std::chrono::milliseconds(10));
+ *     });
+ *     scheduler.Join();
+ */
+class FiberScheduler {
+public:
+    struct Stats {
+        // 累计创建的纤程数
+        uint64_t spawned;
+        // 累计结束的纤程数
+        uint64_t finished;
+        // 累计切换进纤程的次数
+        uint64_t switches;
+        // 累计迁移到其他分片的次数
+        uint64_t migrations;
+        // 栈池从系统申请的内存
+        size_t stack_reserved_bytes;
+    };
+
+public:
+    explicit FiberScheduler(ThreadPool2& pool, const FiberOptions& options = FiberOptions());
+    ~FiberScheduler();
+
+    FiberScheduler(const FiberScheduler&) = delete;
+    FiberScheduler& operator=(const FiberScheduler&) = delete;
+
+    void Spawn(std::function<void()>&& function);
+    // 阻塞调用线程, 直到所有纤程结束, 不能在纤程内调用
+    void Join();
+    size_t LiveCount() const { return live_count_.load(); }
+    Stats GetStats() const;
+
+private:
+    friend struct Fiber;
+    friend class FiberMutex;
+    friend struct FiberRuntime;
+
+    void Schedule(Fiber* fiber);
+    void Resume(Fiber* fiber);
+    void Finish(Fiber* fiber);
+
+private:
+    ThreadPool2& pool_;
+    FiberOptions options_;
+    std::unique_ptr<FiberStackPool> stacks_;
+    uint64_t shard_count_;
+    // 每个分片上等待恢复执行的纤程数
+    std::unique_ptr<std::atomic<int64_t>[]> shard_load_;
+    std::atomic<uint64_t> next_shard_;
+    std::atomic<size_t> live_count_;
+    std::atomic<uint64_t> spawned_;
+    std::atomic<uint64_t> finished_;
+    std::atomic<uint64_t> switches_;
+    std::atomic<uint64_t> migrations_;
+    std::mutex join_mtx_;
+    std::condition_variable join_cv_;
+};
+
+/**
+ * @brief 纤程互斥锁, 等待期间挂起纤程而不阻塞工作线程
+ *
+ * 解锁时直接把锁交给第一个等待的纤程. 在纤程之外调用Lock时退化为让出线程的自旋等待
+ */
+class FiberMutex {
+public:
+    FiberMutex();
+
+    FiberMutex(const FiberMutex&) = delete;
+    FiberMutex& operator=(const FiberMutex&) = delete;
+
+    void Lock();
+    bool TryLock();
+    void Unlock();
+
+    // 用于std::lock_guard/std::unique_lock
+    void lock() { Lock(); }
+    bool try_lock() { return TryLock(); }
+    void unlock() { Unlock(); }
+
+private:
+    std::mutex mtx_;
+    bool locked_;
+    std::deque<Fiber*> waiters_;
+};
+
+namespace this_fiber {
+
+// 当前线程是否正在执行纤程
+bool InFiber();
+// 让出当前纤程, 不在纤程中时让出线程
+void Yield();
+// 挂起当前纤程指定时长, 不在纤程中时休眠线程
+void SleepFor(std::chrono::steady_clock::duration duration);
+
+}
+
+}
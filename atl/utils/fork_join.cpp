@@ -0,0 +1,33 @@
+#include "atl/utils/fork_join.h"
+
+namespace atl {
+
+ForkJoinGroup::ForkJoinGroup(ThreadPool& pool)
+    : pool_(pool)
+    , pending_(0) {}
+
+ForkJoinGroup::~ForkJoinGroup() {
+    // 析构时不能抛出异常, 只等待子任务结束
+    HelpWait(pool_, pending_);
+}
+
+void ForkJoinGroup::Sync() {
+    HelpWait(pool_, pending_);
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::swap(error, error_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ForkJoinGroup::Fail(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!error_) {
+        error_ = error;
+    }
+}
+
+}
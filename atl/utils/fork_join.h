@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include "atl/utils/child_task.h"
+#include "atl/utils/thread_pool.h"
+
+namespace atl {
+
+/**
+ * @brief Cilk风格的spawn/sync
+ *
+ * Spawn提交的子任务在工作线程内会进入本线程的队列, Sync等待期间优先执行本线程最新提交的子任务,
+ * 子任务被其他线程窃取时再执行其他等待中的任务, 因此递归的分治算法不会因为等待子任务而死锁.
+ * 子任务抛出的第一个异常在Sync中重新抛出
+ */
+class ForkJoinGroup {
+public:
+    explicit ForkJoinGroup(ThreadPool& pool);
+    ~ForkJoinGroup();
+
+    ForkJoinGroup(const ForkJoinGroup&) = delete;
+    ForkJoinGroup& operator=(const ForkJoinGroup&) = delete;
+
+    // 线程池停止时丢弃的子任务不执行, 但同样计为已结束, Sync不会一直等待
+    template<class FunctionType>
+    void Spawn(FunctionType&& func) {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.PushNode(new ChildTask<ForkJoinGroup, typename std::decay<FunctionType>::type>(
+            this, std::forward<FunctionType>(func)));
+    }
+
+    void Sync();
+
+private:
+    template<class Group, class FunctionType>
+    friend class ChildTask;
+
+    template<class Node>
+    static void Release(Node* node) { delete node; }
+    bool ShouldRun() const { return true; }
+    void Fail(std::exception_ptr error);
+    void Arrive() { pending_.fetch_sub(1, std::memory_order_release); }
+
+private:
+    ThreadPool& pool_;
+    std::atomic<int> pending_;
+    std::mutex mtx_;
+    std::exception_ptr error_;
+};
+
+}
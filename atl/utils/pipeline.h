@@ -0,0 +1,349 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace atl {
+
+/**
+ * @brief 按序号定位的有界环形队列, 用于连接流水线的相邻阶段
+ *
+ * 每个槽位有自己的序号(Vyukov有界队列的做法): 位置pos的写入方等待槽位序号等于pos, 写入后设为pos+1;
+ * 读取方等待槽位序号等于pos+1, 取出后设为pos+capacity. 位置就是元素进入流水线时的序号,
+ * 所以并行阶段乱序完成的元素写回下游队列后仍然按原顺序被读出. 写入方在队列满时等待, 反压由此逐级传到上游.
+ * 串行的读取方用本地游标(SPSC), 并行的读取方用fetch_add领取位置(MPMC).
+ * 先短暂自旋, 然后在条件变量上休眠, 只有存在休眠的线程时发布方才加锁唤醒
+ */
+template<class T>
+class SequenceRing {
+public:
+    explicit SequenceRing(size_t capacity)
+        : capacity_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2)))
+        , mask_(capacity_ - 1)
+        , slots_(new Slot[capacity_])
+        , read_cursor_(0)
+        , waiters_(0)
+        , closed_(false)
+        , end_(UINT64_MAX) {
+        for (size_t i = 0; i < capacity_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SequenceRing(const SequenceRing&) = delete;
+    SequenceRing& operator=(const SequenceRing&) = delete;
+
+    size_t Capacity() const { return capacity_; }
+
+    // 在位置pos写入, 返回等待空位的时间
+    uint64_t Put(uint64_t pos, T&& value) {
+        Slot& slot = slots_[pos & mask_];
+        uint64_t waited = Await([&slot, pos]() { return slot.sequence.load() == pos; });
+        slot.value = std::move(value);
+        Publish(slot, pos + 1);
+        return waited;
+    }
+
+    // 读取位置pos的元素, 流水线关闭且pos不小于元素总数时返回false. 返回时waited为等待的时间
+    bool Take(uint64_t pos, T& value, uint64_t& waited) {
+        Slot& slot = slots_[pos & mask_];
+        waited = Await([this, &slot, pos]() { return slot.sequence.load() == pos + 1 || IsEnd(pos); });
+        if (slot.sequence.load() != pos + 1) {
+            return false;
+        }
+        value = std::move(slot.value);
+        Publish(slot, pos + capacity_);
+        return true;
+    }
+
+    // 并行读取方领取下一个位置
+    uint64_t Claim() { return read_cursor_.fetch_add(1, std::memory_order_relaxed); }
+
+    // 输入结束, 共有count个元素
+    void Close(uint64_t count) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        end_.store(count);
+        closed_.store(true);
+        cv_.notify_all();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    static constexpr int kSpinCount = 128;
+
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    bool IsEnd(uint64_t pos) const { return closed_.load() && pos >= end_.load(); }
+
+    template<class Predicate>
+    uint64_t Await(Predicate ready) {
+        for (int i = 0; i < kSpinCount; i++) {
+            if (ready()) {
+                return 0;
+            }
+            std::this_thread::yield();
+        }
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            waiters_.fetch_add(1);
+            cv_.wait(lock, ready);
+            waiters_.fetch_sub(1);
+        }
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    // 序号的写入和waiters_的读取都是seq_cst, 与Await中先增加waiters_再检查序号配对, 不会丢失唤醒
+    void Publish(Slot& slot, uint64_t sequence) {
+        slot.sequence.store(sequence);
+        if (waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            cv_.notify_all();
+        }
+    }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<uint64_t> read_cursor_;
+    alignas(64) std::atomic<int> waiters_;
+    std::atomic<bool> closed_;
+    std::atomic<uint64_t> end_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
+
+struct PipelineStageStats {
+    std::string name;
+    // 并行度, 串行阶段为1
+    int concurrency;
+    // 已处理的元素数
+    uint64_t processed;
+    // 每秒处理的元素数, 按Start到Close返回(或者到现在)的时间计算
+    double throughput;
+    // 所有线程执行阶段函数的时间之和
+    uint64_t busy_ns;
+    // 等待上游元素的时间之和
+    uint64_t input_wait_ns;
+    // 下游队列满时等待的时间之和, 反映反压
+    uint64_t output_wait_ns;
+};
+
+/**
+ * @brief 多阶段流水线, 每个阶段有自己的线程, 相邻阶段之间用有界的SequenceRing连接
+ *
+ * 串行阶段由一个线程按输入顺序处理, 并行阶段由多个线程同时处理, 元素经过并行阶段后仍保持输入顺序.
+ * 下游处理不过来时上游阶段在写入时等待, 最终Push也会等待. 阶段函数原地修改元素, 抛出异常会导致std::terminate.
+ * T必须可以默认构造和移动赋值. 没有阶段时Start, Start之前或Close之后Push, Start之后添加阶段都会抛出std::logic_error
+ *
+ * 用法:
+ *     atl::Pipeline<Record> pipeline(1024);
+ *     pipeline.AddSerialStage("parse", [](Record& record) { Parse(record); })
+ *             .AddParallelStage("compress", 4, [](Record& record) { Compress(record); })
+ *             .AddSerialStage("write", [&file](Record& record) { file.Write(record); });
+ *     pipeline.Start();
+ *     while (ReadNext(record)) {
+ *         pipeline.Push(std::move(record));
+ *     }
+ *     pipeline.Close();
+ */
+template<class T>
+class Pipeline {
+    static_assert(std::is_default_constructible<T>::value, "Pipeline element must be default constructible");
+
+public:
+    using StageFunction = std::function<void(T&)>;
+
+public:
+    // ring_capacity为每个阶段输入队列的容量, 向上取整为2的幂
+    explicit Pipeline(size_t ring_capacity = 1024)
+        : ring_capacity_(ring_capacity)
+        , started_(false)
+        , next_input_(0)
+        , elapsed_ns_(0) {}
+
+    ~Pipeline() { Close(); }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // 必须在Start之前调用
+    Pipeline& AddSerialStage(std::string name, StageFunction&& function) {
+        return AddStage(std::move(name), 1, std::move(function));
+    }
+
+    // 必须在Start之前调用
+    Pipeline& AddParallelStage(std::string name, int concurrency, StageFunction&& function) {
+        return AddStage(std::move(name), std::max(concurrency, 1), std::move(function));
+    }
+
+    void Start() {
+        if (stages_.empty()) {
+            throw std::logic_error("Pipeline::Start requires at least one stage");
+        }
+        if (started_) {
+            throw std::logic_error("Pipeline::Start called twice");
+        }
+        start_time_ = std::chrono::steady_clock::now();
+        started_ = true;
+        for (size_t i = 0; i < stages_.size(); i++) {
+            Stage& stage = *stages_[i];
+            SequenceRing<T>* output = i + 1 < stages_.size() ? &stages_[i + 1]->input : nullptr;
+            for (int j = 0; j < stage.concurrency; j++) {
+                stage.threads.emplace_back(&Pipeline::StageThread, this, &stage, j, output);
+            }
+        }
+    }
+
+    // 第一个阶段的输入队列满时等待. 可以在多个线程上调用, 元素的顺序为领取序号的顺序
+    void Push(T&& value) {
+        // 检查关闭和领取序号在同一次CAS中完成, 领到序号的元素一定会被Close等到
+        uint64_t pos = next_input_.load(std::memory_order_relaxed);
+        do {
+            if (!started_ || (pos & kClosedBit) != 0) {
+                throw std::logic_error("Pipeline::Push called before Start or after Close");
+            }
+        } while (!next_input_.compare_exchange_weak(pos, pos + 1));
+        stages_.front()->input.Put(pos, std::move(value));
+    }
+
+    // 结束输入并等待已提交的元素流过所有阶段, 之后不能再Push
+    void Close() {
+        if (!started_) {
+            return;
+        }
+        uint64_t count = next_input_.fetch_or(kClosedBit);
+        if ((count & kClosedBit) != 0) {
+            return;
+        }
+        // 每个阶段处理完所有元素后才关闭下游队列, 避免下游在上游写入之前认为输入已结束
+        for (auto& stage : stages_) {
+            stage->input.Close(count);
+            for (auto& thread : stage->threads) {
+                thread.join();
+            }
+        }
+        elapsed_ns_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time_).count());
+    }
+
+    std::vector<PipelineStageStats> GetStats() const {
+        uint64_t elapsed_ns = elapsed_ns_;
+        if (started_ && elapsed_ns == 0) {
+            elapsed_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_time_).count());
+        }
+        std::vector<PipelineStageStats> stats;
+        for (auto& stage : stages_) {
+            PipelineStageStats item{stage->name, stage->concurrency, 0, 0.0, 0, 0, 0};
+            for (int i = 0; i < stage->concurrency; i++) {
+                const Counters& counters = stage->counters[i];
+                item.processed += counters.processed.load(std::memory_order_relaxed);
+                item.busy_ns += counters.busy_ns.load(std::memory_order_relaxed);
+                item.input_wait_ns += counters.input_wait_ns.load(std::memory_order_relaxed);
+                item.output_wait_ns += counters.output_wait_ns.load(std::memory_order_relaxed);
+            }
+            if (elapsed_ns > 0) {
+                item.throughput = static_cast<double>(item.processed) * 1e9 / static_cast<double>(elapsed_ns);
+            }
+            stats.push_back(std::move(item));
+        }
+        return stats;
+    }
+
+private:
+    // next_input_的最高位表示已关闭, 其余位为下一个输入序号
+    static constexpr uint64_t kClosedBit = uint64_t(1) << 63;
+
+    // 每个线程一份, 只有所属线程写入, 用load+store代替原子加
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> busy_ns{0};
+        std::atomic<uint64_t> input_wait_ns{0};
+        std::atomic<uint64_t> output_wait_ns{0};
+    };
+
+    struct Stage {
+        std::string name;
+        int concurrency;
+        StageFunction function;
+        SequenceRing<T> input;
+        std::unique_ptr<Counters[]> counters;
+        std::vector<std::thread> threads;
+
+        Stage(std::string name, int concurrency, StageFunction&& function, size_t capacity)
+            : name(std::move(name))
+            , concurrency(concurrency)
+            , function(std::move(function))
+            , input(capacity)
+            , counters(new Counters[concurrency]) {}
+    };
+
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    Pipeline& AddStage(std::string name, int concurrency, StageFunction&& function) {
+        if (started_) {
+            throw std::logic_error("Pipeline stages must be added before Start");
+        }
+        stages_.emplace_back(new Stage(std::move(name), concurrency, std::move(function), ring_capacity_));
+        return *this;
+    }
+
+    void StageThread(Stage* stage, int index, SequenceRing<T>* output) {
+        Counters& counters = stage->counters[index];
+        bool serial = stage->concurrency == 1;
+        uint64_t pos = serial ? 0 : stage->input.Claim();
+        T value;
+        uint64_t waited = 0;
+        while (stage->input.Take(pos, value, waited)) {
+            Add(counters.input_wait_ns, waited);
+            auto start = std::chrono::steady_clock::now();
+            stage->function(value);
+            Add(counters.busy_ns, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+            Add(counters.processed, 1);
+            if (output != nullptr) {
+                Add(counters.output_wait_ns, output->Put(pos, std::move(value)));
+            }
+            value = T();
+            pos = serial ? pos + 1 : stage->input.Claim();
+        }
+    }
+
+private:
+    size_t ring_capacity_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    bool started_;
+    std::atomic<uint64_t> next_input_;
+    std::chrono::steady_clock::time_point start_time_;
+    uint64_t elapsed_ns_;
+};
+
+}
@@ -0,0 +1,115 @@
+#include "atl/utils/rate_limiter.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "atl/utils/timer_queue.h"
+
+namespace atl {
+
+namespace {
+
+int64_t NowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        TokenBucket::Clock::now().time_since_epoch()).count();
+}
+
+}
+
+TokenBucket::TokenBucket(double rate_per_second, size_t burst)
+    : interval_ns_(static_cast<int64_t>(1e9 / (rate_per_second > 0 ? rate_per_second : 1e-9)))
+    , tolerance_ns_(interval_ns_ * static_cast<int64_t>(burst > 0 ? burst - 1 : 0))
+    , theoretical_arrival_ns_(0) {}
+
+bool TokenBucket::TryAcquire(Clock::duration* wait) {
+    int64_t now = NowNanoseconds();
+    int64_t arrival = theoretical_arrival_ns_.load(std::memory_order_relaxed);
+    for (;;) {
+        int64_t base = std::max(arrival, now);
+        if (base - now > tolerance_ns_) {
+            if (wait != nullptr) {
+                *wait = std::chrono::nanoseconds(base - now - tolerance_ns_);
+            }
+            return false;
+        }
+        if (theoretical_arrival_ns_.compare_exchange_weak(arrival, base + interval_ns_,
+                                                          std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+RateLimitedExecutor::Core::Core(Executor& executor, double rate_per_second, size_t burst)
+    : executor(executor)
+    , bucket(rate_per_second, burst)
+    , pending_count(0)
+    , drain_scheduled(false)
+    , timer_id(0) {}
+
+RateLimitedExecutor::RateLimitedExecutor(Executor& executor, double rate_per_second, size_t burst)
+    : core_(std::make_shared<Core>(executor, rate_per_second, burst)) {}
+
+RateLimitedExecutor::~RateLimitedExecutor() {
+    std::lock_guard<std::mutex> lock(core_->mtx);
+    if (core_->drain_scheduled) {
+        TimerQueue::Default().Cancel(core_->timer_id);
+    }
+}
+
+void RateLimitedExecutor::Execute(std::function<void()>&& task) {
+    // 没有暂存任务时直接获取令牌, 不需要加锁
+    if (core_->pending_count.load(std::memory_order_acquire) == 0 && core_->bucket.TryAcquire()) {
+        core_->executor.Execute(std::move(task));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(core_->mtx);
+    core_->pending.push_back(std::move(task));
+    core_->pending_count.fetch_add(1, std::memory_order_release);
+    if (!core_->drain_scheduled) {
+        core_->drain_scheduled = true;
+        ScheduleDrain(core_, TokenBucket::Clock::duration::zero());
+    }
+}
+
+size_t RateLimitedExecutor::PendingCount() const {
+    return core_->pending_count.load(std::memory_order_acquire);
+}
+
+void RateLimitedExecutor::ScheduleDrain(const std::shared_ptr<Core>& core, TokenBucket::Clock::duration wait) {
+    std::weak_ptr<Core> weak_core = core;
+    core->timer_id = TimerQueue::Default().Schedule(wait, [weak_core]() {
+        std::shared_ptr<Core> core = weak_core.lock();
+        if (core) {
+            Drain(core);
+        }
+    });
+}
+
+void RateLimitedExecutor::Drain(const std::shared_ptr<Core>& core) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(core->mtx);
+        TokenBucket::Clock::duration wait;
+        while (!core->pending.empty()) {
+            if (!core->bucket.TryAcquire(&wait)) {
+                ScheduleDrain(core, wait);
+                break;
+            }
+            ready.push_back(std::move(core->pending.front()));
+            core->pending.pop_front();
+        }
+        if (core->pending.empty()) {
+            core->drain_scheduled = false;
+        }
+    }
+    // 在锁外提交, 下层执行器可以同步回调本对象. 全部提交之后才减少计数,
+    // 期间新提交的任务走加锁路径排在后面, 不会通过无锁路径插队
+    for (auto& task : ready) {
+        core->executor.Execute(std::move(task));
+    }
+    if (!ready.empty()) {
+        core->pending_count.fetch_sub(ready.size(), std::memory_order_release);
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+/**
+ * @brief 令牌桶, 使用GCRA算法, 只用一个原子变量记录理论到达时间, 不需要后台线程补充令牌
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+public:
+    /**
+     * @param rate_per_second 每秒产生的令牌数量
+     * @param burst 桶的容量, 即允许的突发数量
+     */
+    TokenBucket(double rate_per_second, size_t burst);
+
+    /**
+     * @brief 尝试获取一个令牌
+     *
+     * @param wait 获取失败时, 输出下一个令牌可用前需要等待的时间
+     * @return bool 是否获取成功
+     */
+    bool TryAcquire(Clock::duration* wait = nullptr);
+
+private:
+    int64_t interval_ns_;
+    int64_t tolerance_ns_;
+    std::atomic<int64_t> theoretical_arrival_ns_;
+};
+
+/**
+ * @brief 限速执行器, 在ThreadPool/ThreadPool2等执行器之前按令牌桶限速
+ *
+ * 没有令牌时任务暂存在本对象中, 不占用线程池的工作线程和队列,
+ * 等到令牌可用时由TimerQueue::Default()驱动提交给下层执行器. 暂存的任务按提交顺序执行.
+ * 析构时尚未提交的任务被丢弃
+ */
+class RateLimitedExecutor : public Executor {
+public:
+    RateLimitedExecutor(Executor& executor, double rate_per_second, size_t burst);
+    ~RateLimitedExecutor();
+
+    RateLimitedExecutor(const RateLimitedExecutor&) = delete;
+    RateLimitedExecutor& operator=(const RateLimitedExecutor&) = delete;
+
+    void Execute(std::function<void()>&& task) override;
+
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> Push(AsyncFunctionType&& async_function) {
+        using result_type = typename std::result_of<AsyncFunctionType()>::type;
+        auto task = std::make_shared<std::packaged_task<result_type()>>(
+            std::forward<AsyncFunctionType>(async_function));
+        std::future<result_type> future = task->get_future();
+        Execute([task]() { (*task)(); });
+        return future;
+    }
+
+    // 暂存的任务数量, 包括已经取得令牌、正在交给下层执行器的任务
+    size_t PendingCount() const;
+
+private:
+    struct Core {
+        Executor& executor;
+        TokenBucket bucket;
+        std::mutex mtx;
+        std::deque<std::function<void()>> pending;
+        std::atomic<size_t> pending_count;
+        bool drain_scheduled;
+        uint64_t timer_id;
+
+        Core(Executor& executor, double rate_per_second, size_t burst);
+    };
+
+    static void ScheduleDrain(const std::shared_ptr<Core>& core, TokenBucket::Clock::duration wait);
+    static void Drain(const std::shared_ptr<Core>& core);
+
+private:
+    std::shared_ptr<Core> core_;
+};
+
+}
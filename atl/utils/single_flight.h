@@ -0,0 +1,217 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+/**
+ * @brief 合并相同key的并发计算
+ *
+ * 同一个key的计算正在执行时, 重复的PushOnce不再提交任务, 而是返回同一个shared_future.
+ * ttl为0时计算完成后立即从索引中删除; ttl大于0时成功的结果会被缓存ttl时长, 期间的PushOnce直接返回缓存的结果.
+ * 抛出异常的计算结果不会被缓存. 索引按key的哈希值分片, 每个分片单独加锁, 插入时每隔ttl清理一次分片中过期的结果.
+ * 执行器停止而丢弃任务时, future得到std::future_error(broken_promise), 该key从索引中删除, 之后的PushOnce会重新提交.
+ * 对象必须在所有已提交的计算完成或被丢弃之后才能销毁
+ *
+ * 用法:
+ *     atl::SingleFlight<std::string, Profile> flight(pool);
+ *     std::shared_future<Profile> profile = flight.PushOnce(user_id, [user_id]() { return LoadProfile(user_id); });
+ */
+template<class Key, class Value, class Hash = std::hash<Key>>
+class SingleFlight {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kShardCount = 16;
+
+    struct Stats {
+        // 提交到执行器的计算次数
+        size_t executions;
+        // 合并到正在执行的计算上的次数
+        size_t joined;
+        // 命中缓存结果的次数
+        size_t cache_hits;
+    };
+
+public:
+    explicit SingleFlight(Executor& executor, Clock::duration ttl = Clock::duration::zero())
+        : executor_(executor)
+        , ttl_(ttl) {}
+
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    std::shared_future<Value> PushOnce(const Key& key, std::function<Value()>&& async_function) {
+        Shard& shard = GetShard(key);
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            Clock::time_point now = Clock::now();
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end()) {
+                Entry& existing = *it->second;
+                if (!existing.finished) {
+                    shard.joined++;
+                    return existing.future;
+                }
+                if (now < existing.expire_time) {
+                    shard.cache_hits++;
+                    return existing.future;
+                }
+                shard.entries.erase(it);
+            }
+            // 过期的结果只在同一个key再次请求时才会被删除, key很多时需要定期清理
+            if (ttl_ > Clock::duration::zero() && now >= shard.next_sweep_time) {
+                Sweep(shard, now);
+                shard.next_sweep_time = now + ttl_;
+            }
+            entry = std::make_shared<Entry>();
+            shard.entries.emplace(key, entry);
+            shard.executions++;
+        }
+
+        auto call = std::make_shared<Call>(this, key, entry, std::move(async_function));
+        std::shared_future<Value> future = entry->future;
+        executor_.Execute([call]() { call->Run(); });
+        return future;
+    }
+
+    /**
+     * @brief 删除key对应的缓存结果, 正在执行的计算不受影响, 之后的PushOnce会重新计算
+     */
+    void Erase(const Key& key) {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end() && it->second->finished) {
+            shard.entries.erase(it);
+        }
+    }
+
+    // 正在执行和缓存中的key的数量, 包括已过期但还未被删除的key
+    size_t Size() {
+        size_t size = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            size += shard.entries.size();
+        }
+        return size;
+    }
+
+    Stats GetStats() {
+        Stats stats{0, 0, 0};
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            stats.executions += shard.executions;
+            stats.joined += shard.joined;
+            stats.cache_hits += shard.cache_hits;
+        }
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::promise<Value> promise;
+        std::shared_future<Value> future;
+        bool finished;
+        Clock::time_point expire_time;
+
+        Entry()
+            : future(promise.get_future().share())
+            , finished(false) {}
+    };
+
+    // 提交给执行器的一次计算, 任务被丢弃而没有执行时在析构函数中结束计算
+    class Call {
+    public:
+        Call(SingleFlight* flight, const Key& key, const std::shared_ptr<Entry>& entry,
+             std::function<Value()>&& function)
+            : flight_(flight)
+            , key_(key)
+            , entry_(entry)
+            , function_(std::move(function))
+            , done_(false) {}
+
+        ~Call() {
+            if (!done_) {
+                flight_->Finish(key_, entry_, false);
+                entry_->promise.set_exception(
+                    std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+        }
+
+        void Run() {
+            done_ = true;
+            try {
+                Value value = function_();
+                flight_->Finish(key_, entry_, true);
+                entry_->promise.set_value(std::move(value));
+            } catch (...) {
+                flight_->Finish(key_, entry_, false);
+                entry_->promise.set_exception(std::current_exception());
+            }
+        }
+
+    private:
+        SingleFlight* flight_;
+        Key key_;
+        std::shared_ptr<Entry> entry_;
+        std::function<Value()> function_;
+        bool done_;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<Key, std::shared_ptr<Entry>, Hash> entries;
+        Clock::time_point next_sweep_time;
+        size_t executions = 0;
+        size_t joined = 0;
+        size_t cache_hits = 0;
+    };
+
+    Shard& GetShard(const Key& key) {
+        return shards_[Hash()(key) % kShardCount];
+    }
+
+    // 删除分片中所有过期的结果, 调用方持有shard.mtx
+    static void Sweep(Shard& shard, Clock::time_point now) {
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if (it->second->finished && it->second->expire_time <= now) {
+                it = shard.entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void Finish(const Key& key, const std::shared_ptr<Entry>& entry, bool succeeded) {
+        Shard& shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.entries.find(key);
+        // 索引中的可能已经是同一个key的新计算
+        if (it == shard.entries.end() || it->second != entry) {
+            return;
+        }
+        if (succeeded && ttl_ > Clock::duration::zero()) {
+            entry->finished = true;
+            entry->expire_time = Clock::now() + ttl_;
+        } else {
+            shard.entries.erase(it);
+        }
+    }
+
+private:
+    Executor& executor_;
+    Clock::duration ttl_;
+    Shard shards_[kShardCount];
+};
+
+}
@@ -0,0 +1,255 @@
+#include "atl/utils/slab_allocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace atl {
+
+namespace {
+
+constexpr size_t kSizeClasses[] = {32, 48, 64, 96, 128, 192, 256, 384, 512};
+constexpr int kNumSizeClasses = sizeof(kSizeClasses) / sizeof(kSizeClasses[0]);
+constexpr int kLargeSizeClass = kNumSizeClasses;
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct ThreadCache;
+
+// 每个块前面的16字节头部, 记录分配线程和大小级别
+struct alignas(16) BlockHeader {
+    ThreadCache* owner;
+    uint32_t size_class;
+};
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct ThreadCache {
+    FreeBlock* free_lists[kNumSizeClasses];
+    std::atomic<FreeBlock*> remote_free;
+    std::atomic<bool> in_use;
+    std::atomic<size_t> reserved_bytes;
+    // 只由持有缓存的线程修改的计数器, 使用load/store避免原子读改写
+    std::atomic<size_t> allocated_blocks;
+    std::atomic<size_t> allocated_bytes;
+    std::atomic<size_t> local_freed_blocks;
+    std::atomic<size_t> local_freed_bytes;
+    // 由其他线程修改的计数器
+    std::atomic<size_t> remote_freed_blocks;
+    std::atomic<size_t> remote_freed_bytes;
+
+    ThreadCache()
+        : remote_free(nullptr)
+        , in_use(true)
+        , reserved_bytes(0)
+        , allocated_blocks(0)
+        , allocated_bytes(0)
+        , local_freed_blocks(0)
+        , local_freed_bytes(0)
+        , remote_freed_blocks(0)
+        , remote_freed_bytes(0) {
+        for (auto& list : free_lists) {
+            list = nullptr;
+        }
+    }
+};
+
+std::atomic<size_t> large_allocations(0);
+
+// 线程缓存只增不减, 线程退出后由新线程接管
+std::mutex& RegistryMutex() {
+    static std::mutex* mtx = new std::mutex();
+    return *mtx;
+}
+
+std::vector<ThreadCache*>& Registry() {
+    static std::vector<ThreadCache*>* registry = new std::vector<ThreadCache*>();
+    return *registry;
+}
+
+thread_local ThreadCache* current_cache = nullptr;
+
+struct ThreadCacheReleaser {
+    ~ThreadCacheReleaser() {
+        if (current_cache != nullptr) {
+            current_cache->in_use.store(false, std::memory_order_release);
+            current_cache = nullptr;
+        }
+    }
+};
+
+thread_local ThreadCacheReleaser cache_releaser;
+
+ThreadCache* AcquireThreadCache() {
+    // 访问cache_releaser使其在本线程注册析构
+    (void)&cache_releaser;
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    for (ThreadCache* cache : Registry()) {
+        bool expected = false;
+        if (cache->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return cache;
+        }
+    }
+    ThreadCache* cache = new ThreadCache();
+    Registry().push_back(cache);
+    return cache;
+}
+
+// 以16字节为单位的请求大小到大小级别的映射
+struct SizeClassTable {
+    uint8_t classes[SlabAllocator::kMaxSlabSize / 16 + 1];
+
+    SizeClassTable() {
+        int size_class = 0;
+        for (size_t i = 0; i < sizeof(classes); i++) {
+            while (kSizeClasses[size_class] < i * 16) {
+                size_class++;
+            }
+            classes[i] = static_cast<uint8_t>(size_class);
+        }
+    }
+};
+
+const SizeClassTable size_class_table;
+
+int SizeClassOf(size_t size) {
+    if (size > SlabAllocator::kMaxSlabSize) {
+        return kLargeSizeClass;
+    }
+    return size_class_table.classes[(size + 15) / 16];
+}
+
+void AddOwnerCounter(std::atomic<size_t>& counter, size_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+size_t BlockSize(int size_class) {
+    return sizeof(BlockHeader) + kSizeClasses[size_class];
+}
+
+void* ToUser(BlockHeader* header) {
+    return header + 1;
+}
+
+BlockHeader* ToHeader(void* ptr) {
+    return static_cast<BlockHeader*>(ptr) - 1;
+}
+
+// 把其他线程归还的块放回本线程的空闲链表
+void DrainRemoteFree(ThreadCache* cache) {
+    FreeBlock* block = cache->remote_free.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        FreeBlock* next = block->next;
+        BlockHeader* header = ToHeader(block);
+        block->next = cache->free_lists[header->size_class];
+        cache->free_lists[header->size_class] = block;
+        block = next;
+    }
+}
+
+void Refill(ThreadCache* cache, int size_class) {
+    char* chunk = static_cast<char*>(std::malloc(kChunkSize));
+    if (chunk == nullptr) {
+        throw std::bad_alloc();
+    }
+    cache->reserved_bytes.fetch_add(kChunkSize, std::memory_order_relaxed);
+    size_t block_size = BlockSize(size_class);
+    for (size_t offset = 0; offset + block_size <= kChunkSize; offset += block_size) {
+        BlockHeader* header = reinterpret_cast<BlockHeader*>(chunk + offset);
+        header->owner = cache;
+        header->size_class = static_cast<uint32_t>(size_class);
+        FreeBlock* block = static_cast<FreeBlock*>(ToUser(header));
+        block->next = cache->free_lists[size_class];
+        cache->free_lists[size_class] = block;
+    }
+}
+
+}
+
+void* SlabAllocator::Allocate(size_t size) {
+    int size_class = SizeClassOf(size);
+    if (size_class == kLargeSizeClass) {
+        BlockHeader* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+        if (header == nullptr) {
+            throw std::bad_alloc();
+        }
+        header->owner = nullptr;
+        header->size_class = kLargeSizeClass;
+        large_allocations.fetch_add(1, std::memory_order_relaxed);
+        return ToUser(header);
+    }
+
+    ThreadCache* cache = current_cache;
+    if (cache == nullptr) {
+        cache = AcquireThreadCache();
+        current_cache = cache;
+    }
+    if (cache->free_lists[size_class] == nullptr) {
+        DrainRemoteFree(cache);
+        if (cache->free_lists[size_class] == nullptr) {
+            Refill(cache, size_class);
+        }
+    }
+    FreeBlock* block = cache->free_lists[size_class];
+    cache->free_lists[size_class] = block->next;
+    AddOwnerCounter(cache->allocated_blocks, 1);
+    AddOwnerCounter(cache->allocated_bytes, kSizeClasses[size_class]);
+    return block;
+}
+
+void SlabAllocator::Free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    BlockHeader* header = ToHeader(ptr);
+    if (header->size_class == kLargeSizeClass) {
+        std::free(header);
+        return;
+    }
+
+    ThreadCache* owner = header->owner;
+    uint32_t size_class = header->size_class;
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    if (owner == current_cache) {
+        AddOwnerCounter(owner->local_freed_blocks, 1);
+        AddOwnerCounter(owner->local_freed_bytes, kSizeClasses[size_class]);
+        block->next = owner->free_lists[size_class];
+        owner->free_lists[size_class] = block;
+        return;
+    }
+    // 只有分配线程会一次性取走整个链表, 因此这里的无锁入栈不存在ABA问题
+    owner->remote_freed_blocks.fetch_add(1, std::memory_order_relaxed);
+    owner->remote_freed_bytes.fetch_add(kSizeClasses[size_class], std::memory_order_relaxed);
+    FreeBlock* head = owner->remote_free.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!owner->remote_free.compare_exchange_weak(head, block,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed));
+}
+
+SlabAllocator::Stats SlabAllocator::GetStats() {
+    Stats stats = {};
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    for (ThreadCache* cache : Registry()) {
+        size_t remote_freed_blocks = cache->remote_freed_blocks.load(std::memory_order_relaxed);
+        size_t freed_blocks = cache->local_freed_blocks.load(std::memory_order_relaxed) + remote_freed_blocks;
+        size_t freed_bytes = cache->local_freed_bytes.load(std::memory_order_relaxed)
+                             + cache->remote_freed_bytes.load(std::memory_order_relaxed);
+        stats.reserved_bytes += cache->reserved_bytes.load(std::memory_order_relaxed);
+        stats.used_blocks += cache->allocated_blocks.load(std::memory_order_relaxed) - freed_blocks;
+        stats.used_bytes += cache->allocated_bytes.load(std::memory_order_relaxed) - freed_bytes;
+        stats.remote_frees += remote_freed_blocks;
+        if (cache->in_use.load(std::memory_order_relaxed)) {
+            stats.thread_caches++;
+        }
+    }
+    stats.large_allocations = large_allocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}
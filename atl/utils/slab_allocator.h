@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace atl {
+
+/**
+ * @brief 按大小分级的线程本地内存池
+ *
+ * 每个线程有自己的空闲链表, 本线程释放的内存直接放回本线程的空闲链表;
+ * 其他线程释放的内存通过无锁链表还给分配它的线程, 由分配线程在下次分配时批量回收.
+ * 线程退出后其缓存会被新线程接管, 内存不会还给系统.
+ * 超过kMaxSlabSize的请求直接使用malloc
+ */
+class SlabAllocator {
+public:
+    static constexpr size_t kMaxSlabSize = 512;
+
+    struct Stats {
+        // 从系统申请的slab内存总量
+        size_t reserved_bytes;
+        // 当前正在使用的slab块数量
+        size_t used_blocks;
+        // 当前正在使用的slab块占用的字节数
+        size_t used_bytes;
+        // 由其他线程释放的块数量(累计)
+        size_t remote_frees;
+        // 超过kMaxSlabSize而使用malloc的次数(累计)
+        size_t large_allocations;
+        // 持有缓存的线程数量
+        size_t thread_caches;
+    };
+
+public:
+    static void* Allocate(size_t size);
+    static void Free(void* ptr);
+    static Stats GetStats();
+};
+
+/**
+ * @brief 继承此类的对象使用SlabAllocator分配内存
+ *
+ * slab块按16字节对齐, 对齐要求更高的类型(如含有alignas(32)成员的函数对象)走带对齐参数的重载, 直接从堆上分配
+ */
+class SlabObject {
+public:
+    static void* operator new(size_t size) { return SlabAllocator::Allocate(size); }
+    static void operator delete(void* ptr) { SlabAllocator::Free(ptr); }
+    static void* operator new(size_t size, std::align_val_t align) { return ::operator new(size, align); }
+    static void operator delete(void* ptr, std::align_val_t align) { ::operator delete(ptr, align); }
+};
+
+}
@@ -0,0 +1,124 @@
+#include "atl/utils/task_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace atl {
+
+namespace {
+
+const char* DisplayName(TaskTag tag) {
+    return tag.Id() == 0 ? "(untagged)" : tag.Name();
+}
+
+std::string EscapeJson(const char* text) {
+    std::string escaped;
+    for (const char* p = text; *p != '\0'; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            escaped += buffer;
+        } else {
+            escaped += static_cast<char>(c);
+        }
+    }
+    return escaped;
+}
+
+void AppendTagColumn(std::string& text, const char* name) {
+    constexpr size_t kTagWidth = 32;
+    size_t length = strlen(name);
+    text.append(name, length);
+    if (length < kTagWidth) {
+        text.append(kTagWidth - length, ' ');
+    }
+}
+
+}
+
+void ProfileTable::Record(TaskTag tag, uint64_t wait_ns, uint64_t wall_ns, uint64_t cpu_ns) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    TagProfile& entry = entries_[tag.Id()];
+    entry.tag = tag;
+    entry.count++;
+    entry.wait_ns += wait_ns;
+    entry.wall_ns += wall_ns;
+    entry.cpu_ns += cpu_ns;
+}
+
+void ProfileTable::MergeInto(std::unordered_map<uint32_t, TagProfile>& merged) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& item : entries_) {
+        TagProfile& entry = merged[item.first];
+        entry.tag = item.second.tag;
+        entry.count += item.second.count;
+        entry.wait_ns += item.second.wait_ns;
+        entry.wall_ns += item.second.wall_ns;
+        entry.cpu_ns += item.second.cpu_ns;
+    }
+}
+
+void ProfileTable::Clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    entries_.clear();
+}
+
+std::vector<TagProfile> TopProfiles(const std::unordered_map<uint32_t, TagProfile>& merged, size_t top_n) {
+    std::vector<TagProfile> profiles;
+    profiles.reserve(merged.size());
+    for (auto& item : merged) {
+        profiles.push_back(item.second);
+    }
+    std::sort(profiles.begin(), profiles.end(), [](const TagProfile& lhs, const TagProfile& rhs) {
+        return lhs.wall_ns != rhs.wall_ns ? lhs.wall_ns > rhs.wall_ns : lhs.tag.Id() < rhs.tag.Id();
+    });
+    if (top_n > 0 && profiles.size() > top_n) {
+        profiles.resize(top_n);
+    }
+    return profiles;
+}
+
+std::string FormatProfileText(const std::vector<TagProfile>& profiles) {
+    // 数值列的宽度有上限, 可以用固定大小的缓冲区; 标签列不截断, 不足32个字符时补齐
+    char numbers[160];
+    snprintf(numbers, sizeof(numbers), " %12s %12s %12s %12s %12s\n",
+             "count", "wait_ms", "wall_ms", "cpu_ms", "avg_wall_us");
+    std::string text;
+    AppendTagColumn(text, "tag");
+    text += numbers;
+    for (const TagProfile& profile : profiles) {
+        snprintf(numbers, sizeof(numbers), " %12llu %12.3f %12.3f %12.3f %12.3f\n",
+                 static_cast<unsigned long long>(profile.count),
+                 static_cast<double>(profile.wait_ns) / 1e6,
+                 static_cast<double>(profile.wall_ns) / 1e6,
+                 static_cast<double>(profile.cpu_ns) / 1e6,
+                 profile.count == 0 ? 0.0 : static_cast<double>(profile.wall_ns) / 1e3 / profile.count);
+        AppendTagColumn(text, DisplayName(profile.tag));
+        text += numbers;
+    }
+    return text;
+}
+
+std::string FormatProfileJson(const std::vector<TagProfile>& profiles) {
+    std::string json = "[";
+    for (size_t i = 0; i < profiles.size(); i++) {
+        const TagProfile& profile = profiles[i];
+        if (i > 0) {
+            json += ",";
+        }
+        json += "{\"tag\":\"" + EscapeJson(DisplayName(profile.tag)) + "\"" +
+                ",\"count\":" + std::to_string(profile.count) +
+                ",\"wait_ns\":" + std::to_string(profile.wait_ns) +
+                ",\"wall_ns\":" + std::to_string(profile.wall_ns) +
+                ",\"cpu_ns\":" + std::to_string(profile.cpu_ns) + "}";
+    }
+    json += "]";
+    return json;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "atl/utils/task_tag.h"
+
+namespace atl {
+
+struct TagProfile {
+    TaskTag tag;
+    // 已执行的任务数
+    uint64_t count;
+    // 从提交到开始执行的时间之和
+    uint64_t wait_ns;
+    // 执行的墙钟时间之和
+    uint64_t wall_ns;
+    // 执行的线程CPU时间之和
+    uint64_t cpu_ns;
+};
+
+/**
+ * @brief 一个线程按任务标签累计的统计
+ *
+ * 只有所属线程写入, 加锁只是为了和合并统计的读取方互斥, 写入时没有竞争
+ */
+class ProfileTable {
+public:
+    void Record(TaskTag tag, uint64_t wait_ns, uint64_t wall_ns, uint64_t cpu_ns);
+    void MergeInto(std::unordered_map<uint32_t, TagProfile>& merged) const;
+    void Clear();
+
+private:
+    mutable std::mutex mtx_;
+    std::unordered_map<uint32_t, TagProfile> entries_;
+};
+
+// 按墙钟时间从大到小排序, 保留前top_n项, top_n为0时保留全部
+std::vector<TagProfile> TopProfiles(const std::unordered_map<uint32_t, TagProfile>& merged, size_t top_n);
+// 每个标签一行, 时间单位为毫秒, 未打标签的任务显示为(untagged)
+std::string FormatProfileText(const std::vector<TagProfile>& profiles);
+// JSON数组, 时间单位为纳秒
+std::string FormatProfileJson(const std::vector<TagProfile>& profiles);
+
+}
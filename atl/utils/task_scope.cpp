@@ -0,0 +1,82 @@
+#include "atl/utils/task_scope.h"
+
+#include <algorithm>
+
+namespace atl {
+
+TaskScope::TaskScope(ThreadPool& pool)
+    : pool_(pool)
+    , pending_(0)
+    , current_chunk_(0)
+    , offset_(0) {}
+
+TaskScope::~TaskScope() {
+    // 析构时不能抛出异常, 只等待子任务结束
+    Wait();
+}
+
+void TaskScope::Join() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(arena_mtx_);
+        current_chunk_ = 0;
+        offset_ = 0;
+    }
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::swap(error, error_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskScope::Cancel() {
+    source_.Cancel();
+}
+
+void* TaskScope::Allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(arena_mtx_);
+    while (current_chunk_ < chunks_.size()) {
+        Chunk& chunk = chunks_[current_chunk_];
+        void* ptr = chunk.data.get() + offset_;
+        size_t space = chunk.size - offset_;
+        if (std::align(alignment, size, ptr, space) != nullptr) {
+            offset_ = static_cast<unsigned char*>(ptr) + size - chunk.data.get();
+            return ptr;
+        }
+        current_chunk_++;
+        offset_ = 0;
+    }
+    // 块大小从kMinChunkSize开始翻倍, 超过块大小的子任务单独占用一块
+    size_t chunk_size = chunks_.empty() ? kMinChunkSize : std::min(chunks_.back().size * 2, kMaxChunkSize);
+    chunk_size = std::max(chunk_size, size + alignment);
+    chunks_.push_back(Chunk{std::unique_ptr<unsigned char[]>(new unsigned char[chunk_size]), chunk_size});
+    current_chunk_ = chunks_.size() - 1;
+    void* ptr = chunks_.back().data.get();
+    size_t space = chunk_size;
+    std::align(alignment, size, ptr, space);
+    offset_ = static_cast<unsigned char*>(ptr) + size - chunks_.back().data.get();
+    return ptr;
+}
+
+void TaskScope::Fail(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!error_) {
+            error_ = error;
+        }
+    }
+    source_.Cancel();
+}
+
+void TaskScope::Arrive() {
+    pending_.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskScope::Wait() {
+    HelpWait(pool_, pending_);
+}
+
+}
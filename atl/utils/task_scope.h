@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "atl/utils/cancellation.h"
+#include "atl/utils/child_task.h"
+#include "atl/utils/thread_pool.h"
+
+namespace atl {
+
+/**
+ * @brief 结构化并发的作用域, 子任务的生命周期不超过作用域
+ *
+ * 子任务节点从作用域自己的内存池中分配, 以ThreadPool::PushNode提交, 每个子任务只有一次指针碰撞式分配.
+ * Join和析构函数等待所有子任务结束, 等待期间通过RunPendingTask帮助执行等待中的任务.
+ * 子任务抛出异常后作用域被取消: 还没开始执行的子任务直接跳过, 正在执行的子任务可以检查Token()尽早返回,
+ * Join重新抛出第一个异常. 析构函数不抛出异常, 需要异常时先调用Join.
+ * 子任务可以在执行期间继续Spawn. Join返回后内存池被复用, 但取消状态不会恢复
+ *
+ * 用法:
+ *     atl::TaskScope scope(pool);
+ *     for (auto& part : parts) {
+ *         scope.Spawn([&part]() { Process(part); });
+ *     }
+ *     scope.Join();
+ */
+class TaskScope {
+public:
+    explicit TaskScope(ThreadPool& pool);
+    ~TaskScope();
+
+    TaskScope(const TaskScope&) = delete;
+    TaskScope& operator=(const TaskScope&) = delete;
+
+    template<class FunctionType>
+    void Spawn(FunctionType&& func) {
+        using Node = ChildTask<TaskScope, std::decay_t<FunctionType>>;
+        void* memory = Allocate(sizeof(Node), alignof(Node));
+        Node* node = new (memory) Node(this, std::forward<FunctionType>(func));
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.PushNode(node);
+    }
+
+    void Join();
+    void Cancel();
+    bool IsCancellationRequested() const { return source_.IsCancellationRequested(); }
+    CancellationToken Token() const { return source_.Token(); }
+    // 当前还没结束的子任务数
+    int Pending() const { return pending_.load(); }
+
+private:
+    template<class Group, class FunctionType>
+    friend class ChildTask;
+
+    // 子任务执行或被丢弃后立即析构, 占用的内存在Join返回或作用域销毁时统一回收
+    template<class Node>
+    static void Release(Node* node) { node->~Node(); }
+    bool ShouldRun() const { return !IsCancellationRequested(); }
+
+    struct Chunk {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    static constexpr size_t kMinChunkSize = 4096;
+    static constexpr size_t kMaxChunkSize = 64 * 1024;
+
+private:
+    void* Allocate(size_t size, size_t alignment);
+    void Fail(std::exception_ptr error);
+    void Arrive();
+    void Wait();
+
+private:
+    ThreadPool& pool_;
+    CancellationSource source_;
+    std::atomic<int> pending_;
+    std::mutex mtx_;
+    std::exception_ptr error_;
+    // 以下三项在arena_mtx_保护下修改, 已分配的内存只在没有子任务时回收
+    std::mutex arena_mtx_;
+    std::vector<Chunk> chunks_;
+    size_t current_chunk_;
+    size_t offset_;
+};
+
+}
@@ -0,0 +1,55 @@
+#include "atl/utils/task_tag.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace atl {
+
+namespace {
+
+struct TagRegistry {
+    std::mutex mtx;
+    std::unordered_map<std::string, uint32_t> ids;
+    // deque中元素的地址保持不变, Name可以直接返回c_str
+    std::deque<std::string> names{std::string()};
+};
+
+TagRegistry& Registry() {
+    static TagRegistry* registry = new TagRegistry();
+    return *registry;
+}
+
+}
+
+TaskTag::TaskTag(const char* name)
+    : id_(0) {
+    TagRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    auto it = registry.ids.find(name);
+    if (it != registry.ids.end()) {
+        id_ = it->second;
+        return;
+    }
+    if (registry.names.size() >= kMaxTags) {
+        return;
+    }
+    id_ = static_cast<uint32_t>(registry.names.size());
+    registry.names.emplace_back(name);
+    registry.ids.emplace(registry.names.back(), id_);
+}
+
+const char* TaskTag::Name(uint32_t id) {
+    TagRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    return id < registry.names.size() ? registry.names[id].c_str() : "";
+}
+
+TaskTag TaskTag::FromId(uint32_t id) {
+    TaskTag tag;
+    tag.id_ = id < kMaxTags ? id : 0;
+    return tag;
+}
+
+}
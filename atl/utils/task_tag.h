@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+namespace atl {
+
+/**
+ * @brief 任务的调用点标签, 通常定义为静态变量
+ *
+ * 构造时在全局表中登记名字并分配编号, 相同的名字得到相同的编号. 默认构造的标签编号为0, 表示未打标签.
+ * 提交任务时通过TaskOptions::tag附带, 看门狗等诊断工具用它说明任务来自哪里
+ *
+ * 用法:
+ *     static const atl::TaskTag kHandleTag("rpc.handle");
+ *     atl::TaskOptions options;
+ *     options.tag = kHandleTag;
+ */
+class TaskTag {
+public:
+    // 编号只保留低24位, 超过上限的名字登记为未打标签
+    static constexpr uint32_t kMaxTags = 1 << 24;
+
+public:
+    constexpr TaskTag() : id_(0) {}
+    explicit TaskTag(const char* name);
+
+    uint32_t Id() const { return id_; }
+    const char* Name() const { return Name(id_); }
+    // 未登记的编号返回空字符串
+    static const char* Name(uint32_t id);
+    static TaskTag FromId(uint32_t id);
+
+    bool operator==(const TaskTag& other) const { return id_ == other.id_; }
+    bool operator!=(const TaskTag& other) const { return id_ != other.id_; }
+
+private:
+    uint32_t id_;
+};
+
+}
+
+#define ATL_TASK_TAG_STRINGIFY_IMPL(x) #x
+#define ATL_TASK_TAG_STRINGIFY(x) ATL_TASK_TAG_STRINGIFY_IMPL(x)
+
+/**
+ * 以"文件:行号"为名字的调用点标签, 每个调用点只在第一次执行时登记一次.
+ * C++17中没有std::source_location, 用宏在调用点展开出一个函数内静态变量
+ *
+ * 用法:
+ *     pool.Push(ATL_CALLSITE_TAG(), []() { ... });
+ */
+#define ATL_CALLSITE_TAG()                                                                     \
+    ([]() -> ::atl::TaskTag {                                                                  \
+        static const ::atl::TaskTag callsite_tag(__FILE__ ":" ATL_TASK_TAG_STRINGIFY(__LINE__)); \
+        return callsite_tag;                                                                   \
+    }())
@@ -1,7 +1,66 @@
 #include "atl/utils/thread_pool.h"
 
+#include <algorithm>
+#include <system_error>
+
+#include <limits.h>
+#include <time.h>
+
 namespace atl {
 
+namespace {
+
+uint64_t ThreadCpuTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ThreadStart {
+    std::function<void()> body;
+    std::string name;
+};
+
+void* ThreadEntry(void* arg) {
+    std::unique_ptr<ThreadStart> start(static_cast<ThreadStart*>(arg));
+    if (!start->name.empty()) {
+        // 线程名最长15个字符
+        std::string name = start->name.substr(0, 15);
+#if defined(__APPLE__)
+        pthread_setname_np(name.c_str());
+#elif defined(__linux__)
+        pthread_setname_np(pthread_self(), name.c_str());
+#endif
+    }
+    start->body();
+    return nullptr;
+}
+
+// 按选项设置栈大小和线程名创建线程, 失败时和std::thread一样抛出std::system_error
+pthread_t LaunchThread(const WorkerThreadOptions& options, std::string&& name, std::function<void()>&& body) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (options.stack_size > 0) {
+        pthread_attr_setstacksize(&attr, std::max<size_t>(options.stack_size, PTHREAD_STACK_MIN));
+    }
+    std::unique_ptr<ThreadStart> start(new ThreadStart{std::move(body), std::move(name)});
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, &ThreadEntry, start.get());
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        throw std::system_error(err, std::generic_category(), "pthread_create");
+    }
+    start.release();
+    return thread;
+}
+
+}
+
 AsyncGroup::~AsyncGroup() {}
 
 AsyncGroupImpl::AsyncGroupImpl(std::function<void()>&& group_finish_callback)
@@ -17,12 +76,25 @@ AsyncGroupImpl::~AsyncGroupImpl() {}
 
 void AsyncGroupImpl::Push(std::function<void()>&& async_task_function)
 {
-    this->task_list.emplace_back(std::make_pair(std::forward<std::function<void()>>(async_task_function), [](){}));
+    Push(TaskOptions(), std::forward<std::function<void()>>(async_task_function), [](){});
 }
 
 void AsyncGroupImpl::Push(std::function<void()>&& async_task_function, std::function<void()>&& finish_callback) {
-    this->task_list.emplace_back(std::make_pair(std::forward<std::function<void()>>(async_task_function),
-                                                std::forward<std::function<void()>>(finish_callback)));
+    Push(TaskOptions(),
+         std::forward<std::function<void()>>(async_task_function),
+         std::forward<std::function<void()>>(finish_callback));
+}
+
+void AsyncGroupImpl::Push(const TaskOptions& options, std::function<void()>&& async_task_function) {
+    Push(options, std::forward<std::function<void()>>(async_task_function), [](){});
+}
+
+void AsyncGroupImpl::Push(const TaskOptions& options,
+                          std::function<void()>&& async_task_function,
+                          std::function<void()>&& finish_callback) {
+    this->task_list.emplace_back(AsyncGroupTask{std::forward<std::function<void()>>(async_task_function),
+                                                std::forward<std::function<void()>>(finish_callback),
+                                                options});
 }
 
 bool AsyncGroupImpl::IsAllFinished() {
@@ -35,95 +107,817 @@ AsyncTaskCallable::CallableBase::~CallableBase() {}
 
 AsyncTaskCallable::AsyncTaskCallable() noexcept {
     group = nullptr;
+    node = nullptr;
+    tenant_counters = nullptr;
+}
+
+AsyncTaskCallable::AsyncTaskCallable(TaskNode* node) noexcept {
+    group = nullptr;
+    this->node = node;
+    tenant_counters = nullptr;
 }
 
 AsyncTaskCallable::AsyncTaskCallable(AsyncTaskCallable&& other) {
     group = other.group;
     callable = std::move(other.callable);
+    node = other.node;
+    options = std::move(other.options);
+    enqueue_time = other.enqueue_time;
+    tenant_counters = other.tenant_counters;
     other.group = nullptr;
+    other.node = nullptr;
 }
 
 AsyncTaskCallable& AsyncTaskCallable::operator=(AsyncTaskCallable &&other) {
+    if (node != nullptr) {
+        node->Discard();
+    }
     group = other.group;
     callable = std::move(other.callable);
+    node = other.node;
+    options = std::move(other.options);
+    enqueue_time = other.enqueue_time;
+    tenant_counters = other.tenant_counters;
     other.group = nullptr;
+    other.node = nullptr;
     return *this;
 }
 
+AsyncTaskCallable::~AsyncTaskCallable() {
+    if (node != nullptr) {
+        node->Discard();
+    }
+}
+
+void AsyncTaskCallable::Invoke() {
+    if (node != nullptr) {
+        TaskNode* current = node;
+        node = nullptr;
+        current->Run();
+        return;
+    }
+    callable->CallAsyncFunction();
+    callable->CallFinishCallback();
+}
+
+TaskQueue::TaskQueue(SchedulingMode mode)
+    : mode_(mode)
+    , sequence_(0)
+    , size_(0) {}
+
+bool TaskQueue::LaterDeadline::operator()(const Entry& lhs, const Entry& rhs) const {
+    if (lhs.task.options.deadline != rhs.task.options.deadline) {
+        return lhs.task.options.deadline > rhs.task.options.deadline;
+    }
+    return lhs.sequence > rhs.sequence;
+}
+
+void TaskQueue::SetMode(SchedulingMode mode) {
+    if (mode_ == mode) {
+        return;
+    }
+    std::vector<Entry> entries;
+    for (auto& entry : entries_) {
+        entries.push_back(std::move(entry));
+    }
+    entries_.clear();
+    for (auto& item : tenants_) {
+        for (auto& entry : item.second.entries) {
+            entries.push_back(std::move(entry));
+        }
+        item.second.entries.clear();
+        item.second.deficit = 0;
+        item.second.active = false;
+    }
+    active_tenants_.clear();
+    std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.sequence < rhs.sequence;
+    });
+
+    mode_ = mode;
+    size_ = 0;
+    for (auto& entry : entries) {
+        PushEntry(std::move(entry));
+    }
+}
+
+void TaskQueue::Push(AsyncTaskCallable&& task) {
+    PushEntry(Entry{sequence_++, std::move(task)});
+}
+
+void TaskQueue::PushEntry(Entry&& entry) {
+    size_++;
+    if (mode_ == SchedulingMode::kWeightedFair) {
+        Tenant& tenant = GetTenant(entry.task.options.tenant);
+        tenant.entries.push_back(std::move(entry));
+        if (!tenant.active) {
+            tenant.active = true;
+            active_tenants_.push_back(&tenant);
+        }
+        return;
+    }
+    entries_.push_back(std::move(entry));
+    if (mode_ == SchedulingMode::kEarliestDeadlineFirst) {
+        std::push_heap(entries_.begin(), entries_.end(), LaterDeadline());
+    }
+}
+
+bool TaskQueue::Pop(AsyncTaskCallable& task) {
+    if (size_ == 0) {
+        return false;
+    }
+    size_--;
+    if (mode_ == SchedulingMode::kWeightedFair) {
+        Tenant* tenant = active_tenants_.front();
+        if (tenant->deficit == 0) {
+            tenant->deficit = tenant->weight;
+        }
+        task = std::move(tenant->entries.front().task);
+        task.tenant_counters = &tenant->counters;
+        tenant->entries.pop_front();
+        tenant->deficit--;
+        if (tenant->entries.empty()) {
+            // 队列为空的租户不保留差额
+            tenant->deficit = 0;
+            tenant->active = false;
+            active_tenants_.pop_front();
+        } else if (tenant->deficit == 0) {
+            active_tenants_.pop_front();
+            active_tenants_.push_back(tenant);
+        }
+    } else if (mode_ == SchedulingMode::kEarliestDeadlineFirst) {
+        std::pop_heap(entries_.begin(), entries_.end(), LaterDeadline());
+        task = std::move(entries_.back().task);
+        entries_.pop_back();
+    } else {
+        task = std::move(entries_.front().task);
+        entries_.pop_front();
+    }
+    return true;
+}
+
+void TaskQueue::Clear() {
+    entries_.clear();
+    for (auto& item : tenants_) {
+        item.second.entries.clear();
+        item.second.deficit = 0;
+        item.second.active = false;
+    }
+    active_tenants_.clear();
+    size_ = 0;
+}
+
+void TaskQueue::Drain(std::vector<AsyncTaskCallable>& tasks) {
+    for (auto& entry : entries_) {
+        tasks.push_back(std::move(entry.task));
+    }
+    for (auto& item : tenants_) {
+        for (auto& entry : item.second.entries) {
+            tasks.push_back(std::move(entry.task));
+        }
+    }
+    Clear();
+}
+
+void TaskQueue::SetTenantWeight(uint32_t tenant, uint32_t weight) {
+    GetTenant(tenant).weight = std::max<uint32_t>(weight, 1);
+}
+
+std::vector<TenantStats> TaskQueue::GetTenantStats() const {
+    std::vector<TenantStats> stats;
+    for (auto& item : tenants_) {
+        const Tenant& tenant = item.second;
+        stats.push_back(TenantStats{item.first,
+                                    tenant.weight,
+                                    tenant.entries.size(),
+                                    tenant.counters.executed.load(std::memory_order_relaxed),
+                                    tenant.counters.wait_ns.load(std::memory_order_relaxed),
+                                    tenant.counters.cpu_ns.load(std::memory_order_relaxed)});
+    }
+    std::sort(stats.begin(), stats.end(), [](const TenantStats& lhs, const TenantStats& rhs) {
+        return lhs.tenant < rhs.tenant;
+    });
+    return stats;
+}
+
+TaskQueue::Tenant& TaskQueue::GetTenant(uint32_t tenant) {
+    // unordered_map的元素地址在插入后保持不变, active_tenants_可以直接保存指针
+    return tenants_[tenant];
+}
+
+thread_local ThreadPool::Worker* ThreadPool::current_worker_ = nullptr;
+thread_local int ThreadPool::help_depth_ = 0;
+
+int CurrentWorkerIndex(const Executor* owner) {
+    ThreadPool::Worker* worker = ThreadPool::current_worker_;
+    return worker != nullptr && worker->owner == owner ? worker->index : -1;
+}
+
 ThreadPool::ThreadPool()
-    : next_(false) {}
+    : started_workers_(0)
+    , start_ns_(0)
+    , first_push_ns_(0)
+    , first_run_ns_(0)
+    , local_task_count_(0)
+    , sleeping_count_(0)
+    , next_(false)
+    , profiling_(false)
+    , owner_(this)
+    , index_base_(0)
+    , locals_(std::make_shared<WorkerLocalRegistry>())
+    , watchdog_(nullptr)
+    , lent_slots_(0)
+    , active_spares_(0)
+    , idle_spares_(0)
+    , spare_wakeups_(0)
+    , sleeping_spares_(0) {}
+
+void ThreadPool::SetSchedulingMode(SchedulingMode mode) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tasks_.SetMode(mode);
+}
+
+void ThreadPool::EnableAdmissionControl(AdmissionController::Clock::duration target,
+                                        AdmissionController::Clock::duration interval) {
+    admission_.reset(new AdmissionController(target, interval));
+}
+
+AdmissionController::Stats ThreadPool::GetAdmissionStats() const {
+    if (!admission_) {
+        return AdmissionController::Stats{0, 0, 0, false};
+    }
+    return admission_->GetStats();
+}
+
+void ThreadPool::SetTenantWeight(uint32_t tenant, uint32_t weight) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tasks_.SetTenantWeight(tenant, weight);
+}
+
+std::vector<TenantStats> ThreadPool::GetTenantStats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return tasks_.GetTenantStats();
+}
+
+void ThreadPool::SetWorkerThreadOptions(const WorkerThreadOptions& options) {
+    thread_options_ = options;
+}
+
+void ThreadPool::EnableWatchdog(std::chrono::milliseconds threshold, Watchdog::Reporter&& reporter) {
+    own_watchdog_.reset(new Watchdog(threshold, std::move(reporter)));
+    own_watchdog_->Watch(this);
+    watchdog_ = own_watchdog_.get();
+}
+
+PoolState ThreadPool::GetState() {
+    PoolState state;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        state.global_queue = tasks_.Size();
+    }
+    for (auto& worker : workers_) {
+        size_t local_queue = 0;
+        {
+            std::lock_guard<std::mutex> lock(worker->mtx);
+            local_queue = worker->local_tasks.size() + (worker->next_slot.Empty() ? 0 : 1);
+        }
+        if (watchdog_ != nullptr) {
+            state.workers.push_back(watchdog_->Decode(worker->index, worker->running.load(std::memory_order_relaxed),
+                                                      local_queue));
+        } else {
+            state.workers.push_back(WorkerState{worker->index, false, std::chrono::milliseconds(0), TaskTag(),
+                                                local_queue});
+        }
+    }
+    return state;
+}
+
+void ThreadPool::EnableProfiling() {
+    profiling_ = true;
+}
+
+std::vector<TagProfile> ThreadPool::GetProfile(size_t top_n) {
+    std::unordered_map<uint32_t, TagProfile> merged;
+    CollectProfile(merged);
+    return TopProfiles(merged, top_n);
+}
+
+void ThreadPool::ResetProfile() {
+    for (auto& worker : workers_) {
+        worker->profile.Clear();
+    }
+    other_profile_.Clear();
+}
+
+void ThreadPool::CollectProfile(std::unordered_map<uint32_t, TagProfile>& merged) {
+    for (auto& worker : workers_) {
+        worker->profile.MergeInto(merged);
+    }
+    other_profile_.MergeInto(merged);
+}
+
+void ThreadPool::RecordProfile(const AsyncTaskCallable& task, uint64_t wait_ns, uint64_t wall_ns, uint64_t cpu_ns) {
+    Worker* worker = current_worker_;
+    ProfileTable& table = worker != nullptr && worker->pool == this ? worker->profile : other_profile_;
+    table.Record(task.options.tag, wait_ns, wall_ns, cpu_ns);
+}
+
+StartupStats ThreadPool::GetStartupStats() const {
+    int64_t first_push = first_push_ns_.load();
+    int64_t first_run = first_run_ns_.load();
+    return StartupStats{static_cast<int>(started_workers_.load()),
+                        start_ns_,
+                        first_run == 0 ? -1 : std::max<int64_t>(first_run - first_push, 0)};
+}
 
 AsyncGroup* ThreadPool::CreateAsyncGroup(std::function<void()>&& group_finish_callback) {
     return new AsyncGroupImpl(std::forward<std::function<void()>>(group_finish_callback));
 }
 
 void ThreadPool::Start(int pool_size) {
+    int64_t start = SteadyNowNs();
     if (pool_size <= 0) {
         pool_size = static_cast<int>(std::thread::hardware_concurrency());
     }
     next_ = true;
+    if (owner_ == this) {
+        locals_->SetWorkerCount(static_cast<size_t>(pool_size));
+    }
     for (int i = 0; i < pool_size; i++) {
-        pool_.push_back(std::thread(&ThreadPool::WorkThread, this));
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->pool = this;
+        worker->owner = owner_;
+        worker->index = index_base_ + i;
+        worker->next_slot_runs = 0;
+        worker->tick = 0;
+        worker->blocking_depth = 0;
+        worker->running.store(0);
+        worker->run_sequence = 0;
+        workers_.push_back(std::move(worker));
+    }
+    if (!thread_options_.lazy_start) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& worker : workers_) {
+            LaunchWorker(worker.get());
+        }
     }
+    if (own_watchdog_) {
+        own_watchdog_->Start();
+    }
+    start_ns_ = SteadyNowNs() - start;
 }
 
 void ThreadPool::Push(AsyncGroup* group) {
     AsyncGroupImpl* impl = static_cast<AsyncGroupImpl*>(group);
-    std::lock_guard<std::mutex> lock(mtx_);
-    for (auto& pair : impl->task_list) {
-        tasks_.emplace(AsyncTaskCallable(std::move(pair.first), std::move(pair.second)));
-        tasks_.back().group = group;
+    std::vector<AsyncTaskCallable> rejected;
+    RecordFirstPush();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& item : impl->task_list) {
+            AsyncTaskCallable task(std::move(item.async_function), std::move(item.finish_callback));
+            task.group = group;
+            task.options = std::move(item.options);
+            if (!Admit(task)) {
+                rejected.push_back(std::move(task));
+                continue;
+            }
+            tasks_.Push(std::move(task));
+        }
+        GrowIfNeeded();
+        cv_.notify_all();
+        spare_task_cv_.notify_all();
+    }
+    // 分组可能在最后一个被拒绝的任务完成计数时被删除, 所以放在遍历task_list之后
+    for (auto& task : rejected) {
+        Reject(task);
+    }
+}
+
+void ThreadPool::Execute(std::function<void()>&& task) {
+    Push(std::move(task), [](){});
+}
+
+void ThreadPool::PushNode(TaskNode* node) {
+    if (!next_) {
+        node->Discard();
+        return;
     }
-    cv_.notify_all();
+    Enqueue(AsyncTaskCallable(node), TaskOptions());
 }
 
 void ThreadPool::Stop() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    next_ = false;
-    while (!tasks_.empty()) {
-        tasks_.pop();
+    // 丢弃的任务在锁外销毁, 任务节点的Discard可能继续提交任务
+    std::vector<AsyncTaskCallable> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        next_ = false;
+        tasks_.Drain(dropped);
+        for (auto& worker : workers_) {
+            std::lock_guard<std::mutex> worker_lock(worker->mtx);
+            size_t count = worker->local_tasks.size();
+            if (!worker->next_slot.Empty()) {
+                dropped.push_back(std::move(worker->next_slot));
+                count++;
+            }
+            for (auto& task : worker->local_tasks) {
+                dropped.push_back(std::move(task));
+            }
+            worker->local_tasks.clear();
+            local_task_count_.fetch_sub(count);
+        }
+        cv_.notify_all();
+        spare_cv_.notify_all();
+        spare_task_cv_.notify_all();
+    }
+    if (own_watchdog_) {
+        own_watchdog_->Stop();
     }
-    cv_.notify_all();
+    blocking_pool_.Stop();
 }
 
 void ThreadPool::Wait() {
-    for (auto& thrd : pool_) {
-        thrd.join();
+    // Stop之后不会再创建工作线程和补偿线程
+    std::vector<pthread_t> threads;
+    std::vector<pthread_t> spares;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        threads.swap(pool_);
+        spares.swap(spares_);
+    }
+    for (pthread_t thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+    for (pthread_t thread : spares) {
+        pthread_join(thread, nullptr);
+    }
+    blocking_pool_.Wait();
+}
+
+bool ThreadPool::RunPendingTask() {
+    if (!next_ || help_depth_ >= kMaxHelpDepth) {
+        return false;
+    }
+    Worker* worker = current_worker_;
+    if (worker != nullptr && worker->pool != this) {
+        worker = nullptr;
+    }
+    AsyncTaskCallable task;
+    if (!(worker != nullptr && PopLocalNewest(worker, task)) && !PopGlobal(task) && !Steal(worker, task)) {
+        return false;
+    }
+    // 工作线程已经在线, 其他线程帮助执行时需要进入保护区
+    EpochGuard guard;
+    help_depth_++;
+    RunTask(task);
+    help_depth_--;
+    return true;
+}
+
+void ThreadPool::Enqueue(AsyncTaskCallable&& task, const TaskOptions& options) {
+    RecordFirstPush();
+    task.options = options;
+    if (!Admit(task)) {
+        Reject(task);
+        return;
+    }
+    // 工作线程内提交的任务放入本线程的队列, 不经过全局锁;
+    // 按截止时间调度或者要求保持提交顺序时必须进入全局队列
+    Worker* worker = current_worker_;
+    if (worker != nullptr && worker->pool == this && tasks_.Mode() == SchedulingMode::kFifo && !options.ordered) {
+        EnqueueLocal(worker, std::move(task));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    tasks_.Push(std::move(task));
+    GrowIfNeeded();
+    NotifyOne();
+}
+
+void ThreadPool::EnqueueLocal(Worker* worker, AsyncTaskCallable&& task) {
+    {
+        std::lock_guard<std::mutex> lock(worker->mtx);
+        if (!worker->next_slot.Empty()) {
+            worker->local_tasks.push_back(std::move(worker->next_slot));
+        }
+        worker->next_slot = std::move(task);
+    }
+    local_task_count_.fetch_add(1);
+    // 只有存在休眠的工作线程或补偿线程时才需要加锁唤醒, 加锁是为了避免丢失唤醒;
+    // 延迟启动时还需要创建一个工作线程来窃取
+    if (sleeping_count_.load() > 0 || sleeping_spares_.load() > 0 || started_workers_.load() < workers_.size()) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        GrowIfNeeded();
+        NotifyOne();
+    }
+}
+
+bool ThreadPool::PopLocal(Worker* worker, AsyncTaskCallable& task) {
+    std::lock_guard<std::mutex> lock(worker->mtx);
+    if (!worker->next_slot.Empty()) {
+        // 连续执行next_slot的次数有限制, 避免互相提交的任务饿死本地队列中的任务
+        if (worker->next_slot_runs < kMaxNextSlotRuns) {
+            worker->next_slot_runs++;
+            task = std::move(worker->next_slot);
+            local_task_count_.fetch_sub(1);
+            return true;
+        }
+        worker->local_tasks.push_back(std::move(worker->next_slot));
+    }
+    worker->next_slot_runs = 0;
+    if (worker->local_tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker->local_tasks.front());
+    worker->local_tasks.pop_front();
+    local_task_count_.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::PopLocalNewest(Worker* worker, AsyncTaskCallable& task) {
+    std::lock_guard<std::mutex> lock(worker->mtx);
+    if (!worker->next_slot.Empty()) {
+        task = std::move(worker->next_slot);
+    } else if (!worker->local_tasks.empty()) {
+        task = std::move(worker->local_tasks.back());
+        worker->local_tasks.pop_back();
+    } else {
+        return false;
+    }
+    local_task_count_.fetch_sub(1);
+    return true;
+}
+
+bool ThreadPool::PopGlobal(AsyncTaskCallable& task) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return tasks_.Pop(task);
+}
+
+bool ThreadPool::Steal(Worker* thief, AsyncTaskCallable& task) {
+    if (local_task_count_.load() == 0) {
+        return false;
+    }
+    for (auto& worker : workers_) {
+        if (worker.get() == thief) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(worker->mtx);
+        if (!worker->local_tasks.empty()) {
+            task = std::move(worker->local_tasks.front());
+            worker->local_tasks.pop_front();
+        } else if (!worker->next_slot.Empty()) {
+            task = std::move(worker->next_slot);
+        } else {
+            continue;
+        }
+        local_task_count_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::NextTask(Worker* worker, AsyncTaskCallable& task) {
+    // 定期优先检查全局队列, 避免本地任务链饿死全局队列中的任务
+    if (++worker->tick % kGlobalQueueInterval == 0 && PopGlobal(task)) {
+        return true;
+    }
+    return PopLocal(worker, task) || PopGlobal(task) || Steal(worker, task);
+}
+
+bool ThreadPool::Admit(AsyncTaskCallable& task) {
+    if (admission_ && !admission_->Admit(task.options.priority)) {
+        return false;
+    }
+    if (admission_ || profiling_ || tasks_.Mode() == SchedulingMode::kWeightedFair) {
+        task.enqueue_time = TaskOptions::Clock::now();
+    }
+    return true;
+}
+
+void ThreadPool::Reject(AsyncTaskCallable& task) {
+    if (task.options.rejected_callback) {
+        task.options.rejected_callback();
+    }
+    FinishTask(task);
+}
+
+void ThreadPool::RunTask(AsyncTaskCallable& task) {
+    // 已取消, 已过期或被丢弃的任务不执行任务函数和任务完成回调, 但仍然计入所属分组的完成数量
+    if (task.options.token.IsCancellationRequested()) {
+        FinishTask(task);
+        return;
+    }
+    TaskOptions::Clock::time_point now;
+    if (task.options.HasDeadline() || admission_ || profiling_ || task.tenant_counters != nullptr) {
+        now = TaskOptions::Clock::now();
+        if (task.options.HasDeadline() && now > task.options.deadline) {
+            if (task.options.expired_callback) {
+                task.options.expired_callback();
+            }
+            FinishTask(task);
+            return;
+        }
+        if (admission_ && admission_->OnDequeue(task.enqueue_time, now, task.options.priority)) {
+            Reject(task);
+            return;
+        }
+    }
+    if (task.tenant_counters == nullptr && !profiling_) {
+        task.Invoke();
+        FinishTask(task);
+        return;
+    }
+    TenantCounters* counters = task.tenant_counters;
+    uint64_t cpu_start = ThreadCpuTimeNs();
+    task.Invoke();
+    uint64_t cpu_ns = ThreadCpuTimeNs() - cpu_start;
+    uint64_t wait_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - task.enqueue_time).count());
+    if (counters != nullptr) {
+        counters->cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+        counters->wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+        counters->executed.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (profiling_) {
+        uint64_t wall_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            TaskOptions::Clock::now() - now).count());
+        RecordProfile(task, wait_ns, wall_ns, cpu_ns);
+    }
+    FinishTask(task);
+}
+
+void ThreadPool::FinishTask(AsyncTaskCallable& task) {
+    if (task.group == nullptr) {
+        return;
+    }
+    AsyncGroupImpl* impl = static_cast<AsyncGroupImpl*>(task.group);
+    if (impl->IsAllFinished()) {
+        if (impl->group_finish_callback) {
+            impl->group_finish_callback();
+        }
+        delete impl;
+    }
+}
+
+void ThreadPool::RecordFirstPush() {
+    if (first_push_ns_.load(std::memory_order_relaxed) == 0) {
+        int64_t expected = 0;
+        first_push_ns_.compare_exchange_strong(expected, SteadyNowNs());
+    }
+}
+
+void ThreadPool::GrowIfNeeded() {
+    size_t started = started_workers_.load();
+    if (started < workers_.size() && sleeping_count_.load() == 0 && next_) {
+        LaunchWorker(workers_[started].get());
+    }
+}
+
+void ThreadPool::NotifyOne() {
+    if (sleeping_count_.load() == 0 && sleeping_spares_.load() > 0) {
+        spare_task_cv_.notify_one();
+    } else {
+        cv_.notify_one();
+    }
+}
+
+void ThreadPool::LaunchWorker(Worker* worker) {
+    std::string name;
+    if (!thread_options_.name.empty()) {
+        name = thread_options_.name + "-" + std::to_string(worker->index);
+    }
+    pool_.push_back(LaunchThread(thread_options_, std::move(name), [this, worker]() { WorkThread(worker); }));
+    started_workers_.fetch_add(1);
+}
+
+void ThreadPool::EnterBlocking() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    lent_slots_.fetch_add(1);
+    if (!next_) {
+        return;
+    }
+    if (idle_spares_ > spare_wakeups_) {
+        spare_wakeups_++;
+        spare_cv_.notify_one();
+    } else {
+        std::string name;
+        if (!thread_options_.name.empty()) {
+            name = thread_options_.name + "-spare";
+        }
+        spares_.push_back(LaunchThread(thread_options_, std::move(name), [this]() { SpareThread(); }));
     }
 }
 
-void ThreadPool::WorkThread() {
+void ThreadPool::LeaveBlocking() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    lent_slots_.fetch_sub(1);
+    // 唤醒休眠的补偿线程, 让多出来的补偿线程转为空闲
+    spare_task_cv_.notify_all();
+}
+
+void ThreadPool::WorkThread(Worker* worker) {
+    current_worker_ = worker;
+    epoch::Online();
     while (next_) {
+        AsyncTaskCallable task;
+        if (NextTask(worker, task)) {
+            if (first_run_ns_.load(std::memory_order_relaxed) == 0) {
+                int64_t expected = 0;
+                first_run_ns_.compare_exchange_strong(expected, SteadyNowNs());
+            }
+            // 延迟启动时还有排队的任务就再创建一个工作线程, 逐个扩展到pool_size
+            if (started_workers_.load() < workers_.size()) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (!tasks_.Empty() || local_task_count_.load() > 0) {
+                    GrowIfNeeded();
+                }
+            }
+            if (watchdog_ != nullptr) {
+                worker->running.store(watchdog_->Stamp(task.options.tag, ++worker->run_sequence), std::memory_order_relaxed);
+            }
+            RunTask(task);
+            // 在任务之间报告静止点, 不能放在RunTask里, 否则帮助执行的嵌套任务会提前报告
+            epoch::QuiescentState();
+            continue;
+        }
+        if (admission_) {
+            admission_->OnIdle();
+        }
+        if (watchdog_ != nullptr) {
+            worker->running.store(0, std::memory_order_relaxed);
+        }
+        // 休眠的线程不阻止推进纪元
+        epoch::Offline();
         {
             std::unique_lock<std::mutex> lock(mtx_);
+            sleeping_count_.fetch_add(1);
             cv_.wait(lock, [this]() -> bool {
-                return !this->tasks_.empty() || !next_;
+                return !this->tasks_.Empty() || this->local_task_count_.load() > 0 || !next_;
             });
+            sleeping_count_.fetch_sub(1);
         }
-        while (next_) {
-            AsyncTaskCallable task;
-            {
-                std::lock_guard<std::mutex> lock(mtx_);
-                if (!tasks_.empty()) {
-                    task = std::move(tasks_.front());
-                    tasks_.pop();
-                }
+        epoch::Online();
+    }
+    epoch::Offline();
+    locals_->DestroyWorker(static_cast<size_t>(worker->index));
+    current_worker_ = nullptr;
+}
+
+void ThreadPool::SpareThread() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    active_spares_.fetch_add(1);
+    while (next_) {
+        if (active_spares_.load() > lent_slots_.load()) {
+            // 借出的槽位已经收回, 转为空闲等待下一次补偿
+            active_spares_.fetch_sub(1);
+            idle_spares_++;
+            spare_cv_.wait(lock, [this]() { return spare_wakeups_ > 0 || !next_; });
+            idle_spares_--;
+            if (spare_wakeups_ > 0) {
+                spare_wakeups_--;
             }
-            if (task.callable) {
-                task.callable->CallAsyncFunction();
-                task.callable->CallFinishCallback();
-                if (task.group == nullptr) {
-                    continue;
-                }
-                AsyncGroupImpl* impl = static_cast<AsyncGroupImpl*>(task.group);
-                if (impl->IsAllFinished()) {
-                    if (impl->group_finish_callback) {
-                        impl->group_finish_callback();
-                    }
-                    delete impl;
-                }
+            active_spares_.fetch_add(1);
+            continue;
+        }
+        lock.unlock();
+        AsyncTaskCallable task;
+        if (PopGlobal(task) || Steal(nullptr, task)) {
+            {
+                // 补偿线程不进入在线状态, 空闲等待时持有mtx_, 不能在那里回收对象
+                EpochGuard guard;
+                RunTask(task);
             }
+            task = AsyncTaskCallable();
+            lock.lock();
+            continue;
         }
+        lock.lock();
+        // 补偿线程不计入sleeping_count_, 否则被阻塞的区域会抑制或触发工作线程的按需创建
+        sleeping_spares_.fetch_add(1);
+        spare_task_cv_.wait(lock, [this]() -> bool {
+            return !this->tasks_.Empty() || this->local_task_count_.load() > 0 || !next_ ||
+                   this->active_spares_.load() > this->lent_slots_.load();
+        });
+        sleeping_spares_.fetch_sub(1);
+    }
+    active_spares_.fetch_sub(1);
+}
+
+BlockingRegion::BlockingRegion()
+    : pool_(nullptr) {
+    ThreadPool::Worker* worker = ThreadPool::current_worker_;
+    if (worker != nullptr && worker->blocking_depth++ == 0) {
+        pool_ = worker->pool;
+        pool_->EnterBlocking();
+    }
+}
+
+BlockingRegion::~BlockingRegion() {
+    ThreadPool::Worker* worker = ThreadPool::current_worker_;
+    if (worker != nullptr) {
+        worker->blocking_depth--;
+    }
+    if (pool_ != nullptr) {
+        pool_->LeaveBlocking();
     }
 }
 
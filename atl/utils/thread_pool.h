@@ -1,30 +1,151 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <mutex>
-#include <queue>
+#include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include <string_view>
+#include <type_traits>
+
+#include <pthread.h>
+
+#include "atl/utils/admission_controller.h"
+#include "atl/utils/blocking_pool.h"
+#include "atl/utils/cancellation.h"
+#include "atl/utils/epoch.h"
+#include "atl/utils/executor.h"
+#include "atl/utils/slab_allocator.h"
+#include "atl/utils/task_profile.h"
+#include "atl/utils/task_tag.h"
+#include "atl/utils/watchdog.h"
+#include "atl/utils/worker_local.h"
 
 namespace atl {
 
+/**
+ * @brief 提交任务时附带的选项
+ *
+ * token: 任务出队时如果已被取消, 则跳过任务函数和任务完成回调,
+ *        通过future等待的调用方会收到std::future_error(broken_promise)
+ * deadline: 任务出队时如果已超过截止时间, 则不执行任务函数和任务完成回调,
+ *           改为调用expired_callback(如果设置了的话)
+ * tenant: 按租户公平调度时任务所属的租户
+ * priority: 启用准入控制时, 过载期间低优先级任务会被拒绝或丢弃, 此时不执行任务函数和任务完成回调,
+ *           改为调用rejected_callback(如果设置了的话). 提交时被拒绝的任务在提交线程上调用rejected_callback
+ * tag: 任务的调用点标签, 看门狗报告卡住的任务时用于说明任务来自哪里, 启用性能统计时按标签分别累计.
+ *      TaskTag可以隐式转换为TaskOptions, 因此可以直接写pool.Push(tag, function)
+ * ordered: 为true时即使在工作线程内提交也进入全局队列, 与其他ordered任务一起按调度模式和提交顺序出队,
+ *          不会被之后提交的任务插队
+ */
+struct TaskOptions {
+    using Clock = std::chrono::steady_clock;
+
+    TaskOptions() = default;
+    TaskOptions(const CancellationToken& token) : token(token) {}
+    TaskOptions(TaskTag tag) : tag(tag) {}
+    TaskOptions(Clock::time_point deadline, std::function<void()> expired_callback = nullptr)
+        : deadline(deadline)
+        , expired_callback(std::move(expired_callback)) {}
+
+    bool HasDeadline() const { return deadline != Clock::time_point::max(); }
+
+    CancellationToken token;
+    Clock::time_point deadline = Clock::time_point::max();
+    std::function<void()> expired_callback;
+    TaskPriority priority = TaskPriority::kNormal;
+    std::function<void()> rejected_callback;
+    uint32_t tenant = 0;
+    TaskTag tag;
+    bool ordered = false;
+};
+
+enum class SchedulingMode {
+    kFifo,
+    // 按截止时间从早到晚出队, 没有截止时间的任务排在最后, 截止时间相同的按提交顺序出队
+    kEarliestDeadlineFirst,
+    // 每个租户一个先进先出队列, 租户之间按权重做差额轮询(DRR), 每次出队O(1)
+    kWeightedFair,
+};
+
+// 租户的累计计数, 由执行任务的工作线程更新
+struct TenantCounters {
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> wait_ns{0};
+    std::atomic<uint64_t> cpu_ns{0};
+};
+
+struct TenantStats {
+    uint32_t tenant;
+    uint32_t weight;
+    // 当前排队的任务数
+    size_t queued;
+    // 已执行的任务数
+    uint64_t executed;
+    // 已执行任务的排队时间之和
+    uint64_t wait_ns;
+    // 已执行任务的线程CPU时间之和
+    uint64_t cpu_ns;
+};
+
+/**
+ * @brief 工作线程的创建选项
+ */
+struct WorkerThreadOptions {
+    // 为true时Start不创建线程, 提交任务时没有空闲的工作线程才逐个创建, 最多创建pool_size个
+    bool lazy_start = false;
+    // 线程栈大小, 0表示使用系统默认值(通常为8MB), 小于PTHREAD_STACK_MIN时按PTHREAD_STACK_MIN创建
+    size_t stack_size = 0;
+    // 线程名前缀, 线程名为"前缀-工作线程序号", 超过15个字符的部分被截断, 为空时不设置
+    std::string name;
+};
+
+struct StartupStats {
+    // 已创建的工作线程数
+    int started_workers;
+    // Start的耗时
+    int64_t start_ns;
+    // 第一个任务从提交到开始执行的耗时, 包括按需创建工作线程的时间, 还没有任务执行时为-1
+    int64_t first_task_latency_ns;
+};
+
+template<class T>
+using EnableIfNotTaskOptions = typename std::enable_if<
+    !std::is_convertible<typename std::decay<T>::type, TaskOptions>::value, int>::type;
+
 class AsyncGroup {
 public:
     virtual ~AsyncGroup();
     virtual void Push(std::function<void()>&& async_task_function) = 0;
     virtual void Push(std::function<void()>&& async_task_function, std::function<void()>&& finish_callback) = 0;
+    virtual void Push(const TaskOptions& options, std::function<void()>&& async_task_function) = 0;
+    virtual void Push(const TaskOptions& options,
+                      std::function<void()>&& async_task_function,
+                      std::function<void()>&& finish_callback) = 0;
 };
 
-class AsyncGroupImpl : public AsyncGroup {
+struct AsyncGroupTask {
+    std::function<void()> async_function;
+    std::function<void()> finish_callback;
+    TaskOptions options;
+};
+
+class AsyncGroupImpl : public AsyncGroup, public SlabObject {
 public:
     AsyncGroupImpl(std::function<void()>&& group_finish_callback);
     virtual ~AsyncGroupImpl();
     void Push(std::function<void()>&& async_task_function) override;
     void Push(std::function<void()>&& async_task_function, std::function<void()>&& finish_callback) override;
+    void Push(const TaskOptions& options, std::function<void()>&& async_task_function) override;
+    void Push(const TaskOptions& options,
+              std::function<void()>&& async_task_function,
+              std::function<void()>&& finish_callback) override;
 
 public:
     bool IsAllFinished();
@@ -32,7 +153,22 @@ public:
 public:
     std::atomic<int> finish_count;
     std::function<void()> group_finish_callback;
-    std::vector<std::pair<std::function<void()>, std::function<void()>>> task_list;
+    std::vector<AsyncGroupTask> task_list;
+};
+
+/**
+ * @brief 由提交方持有内存的任务节点, 通过PushNode提交时不分配内存
+ *
+ * 节点在Run或Discard返回之前必须保持有效, 二者恰好调用其中一个.
+ * 线程池停止时丢弃的节点在Stop中调用Discard, 不持有线程池的锁, Discard中可以继续提交任务
+ */
+class TaskNode {
+public:
+    virtual void Run() = 0;
+    virtual void Discard() = 0;
+
+protected:
+    ~TaskNode() = default;
 };
 
 class AsyncTaskCallable {
@@ -41,7 +177,7 @@ private:
         void operator()() {}
     };
 
-    struct CallableBase {
+    struct CallableBase : public SlabObject {
         virtual ~CallableBase();
         virtual void CallAsyncFunction() = 0;
         virtual void CallFinishCallback() = 0;
@@ -69,81 +205,349 @@ private:
 public:
     AsyncGroup* group;
     std::unique_ptr<CallableBase> callable;
+    // 不为空时callable为空, 任务没有执行就被销毁时调用node->Discard()
+    TaskNode* node;
+    TaskOptions options;
+    // 启用准入控制或按租户公平调度时记录入队时间
+    TaskOptions::Clock::time_point enqueue_time;
+    // 按租户公平调度时由任务队列在出队时设置
+    TenantCounters* tenant_counters;
 
 public:
     AsyncTaskCallable() noexcept;
+    explicit AsyncTaskCallable(TaskNode* node) noexcept;
     template<class FunctionType>
     AsyncTaskCallable(FunctionType&& func) {
         group = nullptr;
+        node = nullptr;
+        tenant_counters = nullptr;
         callable = std::make_unique<CallableImpl<FunctionType, EmptyCallback>>(
             std::forward<FunctionType>(func), EmptyCallback());
     }
     template<class FunctionType, class CallbackType>
     AsyncTaskCallable(FunctionType&& func, CallbackType&& callback) {
         group = nullptr;
+        node = nullptr;
+        tenant_counters = nullptr;
         callable = std::make_unique<CallableImpl<FunctionType, CallbackType>>(
             std::forward<FunctionType>(func),
             std::forward<CallbackType>(callback));
     }
     AsyncTaskCallable(AsyncTaskCallable&& other);
     AsyncTaskCallable& operator=(AsyncTaskCallable&& other);
+    ~AsyncTaskCallable();
+
+    bool Empty() const { return !callable && node == nullptr; }
+    void Invoke();
 
     AsyncTaskCallable(const AsyncTaskCallable&) = delete;
     AsyncTaskCallable& operator=(const AsyncTaskCallable&) = delete;
 };
 
-class ThreadPool {
+class TaskQueue {
+public:
+    explicit TaskQueue(SchedulingMode mode = SchedulingMode::kFifo);
+    SchedulingMode Mode() const { return mode_; }
+    void SetMode(SchedulingMode mode);
+    bool Empty() const { return size_ == 0; }
+    size_t Size() const { return size_; }
+    void Push(AsyncTaskCallable&& task);
+    bool Pop(AsyncTaskCallable& task);
+    void Clear();
+    // 取出所有任务并清空队列
+    void Drain(std::vector<AsyncTaskCallable>& tasks);
+    // 权重为每轮可以出队的任务数, 未设置的租户权重为1
+    void SetTenantWeight(uint32_t tenant, uint32_t weight);
+    std::vector<TenantStats> GetTenantStats() const;
+
+private:
+    struct Entry {
+        uint64_t sequence;
+        AsyncTaskCallable task;
+    };
+    struct LaterDeadline {
+        bool operator()(const Entry& lhs, const Entry& rhs) const;
+    };
+    struct Tenant {
+        std::deque<Entry> entries;
+        uint32_t weight = 1;
+        uint32_t deficit = 0;
+        bool active = false;
+        TenantCounters counters;
+    };
+
+private:
+    void PushEntry(Entry&& entry);
+    Tenant& GetTenant(uint32_t tenant);
+
+private:
+    SchedulingMode mode_;
+    uint64_t sequence_;
+    size_t size_;
+    std::deque<Entry> entries_;
+    std::unordered_map<uint32_t, Tenant> tenants_;
+    // 有任务排队的租户, 队首的租户用完本轮的差额后移到队尾
+    std::deque<Tenant*> active_tenants_;
+};
+
+/**
+ * @brief 线程池
+ *
+ * 其他线程提交的任务进入全局队列, 按调度模式出队. 先进先出模式下工作线程内提交的任务进入本线程的队列:
+ * 最新提交的任务放入next_slot, 本线程接下来就执行它(后进先出), 被挤出的任务按提交顺序排在本地队列末尾,
+ * 本地队列优先于全局队列执行. 需要和全局队列中的任务保持提交顺序时在TaskOptions中设置ordered
+ */
+class ThreadPool : public Executor {
 public:
     static AsyncGroup* CreateAsyncGroup(std::function<void()>&& group_finish_callback = nullptr);
 
 public:
     ThreadPool();
     bool IsStopped() const { return !next_; }
+    // 必须在Start之前调用
+    void SetSchedulingMode(SchedulingMode mode);
+    // 启用按排队时间的准入控制, 必须在Start之前调用
+    void EnableAdmissionControl(AdmissionController::Clock::duration target = std::chrono::milliseconds(5),
+                                AdmissionController::Clock::duration interval = std::chrono::milliseconds(100));
+    // 未启用准入控制时各项均为0
+    AdmissionController::Stats GetAdmissionStats() const;
+    // 按租户公平调度时租户的权重, 可以随时调用
+    void SetTenantWeight(uint32_t tenant, uint32_t weight);
+    std::vector<TenantStats> GetTenantStats();
+    // 必须在Start之前调用, 补偿线程使用相同的栈大小
+    void SetWorkerThreadOptions(const WorkerThreadOptions& options);
+    // 启用看门狗线程, 任务执行超过threshold时调用reporter, 必须在Start之前调用
+    void EnableWatchdog(std::chrono::milliseconds threshold, Watchdog::Reporter&& reporter = nullptr);
+    // 各队列的长度和工作线程正在执行的任务, 未启用看门狗时所有工作线程都显示为空闲
+    PoolState GetState();
+    std::string DumpState() { return FormatPoolState(GetState()); }
+    // 按任务标签统计次数, 排队时间, 墙钟时间和线程CPU时间, 必须在Start之前调用
+    void EnableProfiling();
+    // 合并所有工作线程的统计, 按墙钟时间从大到小排序, top_n为0时返回全部.
+    // 可以用FormatProfileText/FormatProfileJson导出
+    std::vector<TagProfile> GetProfile(size_t top_n = 0);
+    void ResetProfile();
+    StartupStats GetStartupStats() const;
     void Start(int pool_size = 0);
 
     template<class AsyncFunctionType>
     std::future<typename std::result_of<AsyncFunctionType()>::type> Push(AsyncFunctionType&& async_function) {
+        return Push(TaskOptions(), std::forward<AsyncFunctionType>(async_function));
+    }
+
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> Push(const TaskOptions& options,
+                                                                        AsyncFunctionType&& async_function) {
         using result_type = typename std::result_of<AsyncFunctionType()>::type;
-        std::packaged_task<result_type()> task(std::move(async_function));
+        std::packaged_task<result_type()> task(std::forward<AsyncFunctionType>(async_function));
         std::future<result_type> future = task.get_future();
-        std::lock_guard<std::mutex> lock(mtx_);
-        tasks_.emplace(AsyncTaskCallable(std::move(task)));
-        cv_.notify_one();
+        Enqueue(AsyncTaskCallable(std::move(task)), options);
         return future;
     }
 
-    template<class AsyncFunctionType, class CallbackType>
+    template<class AsyncFunctionType, class CallbackType, EnableIfNotTaskOptions<AsyncFunctionType> = 0>
     void Push(AsyncFunctionType&& async_function,
               CallbackType&& callback_function) {
-        std::lock_guard<std::mutex> lock(mtx_);
-        tasks_.emplace(AsyncTaskCallable(std::forward<AsyncFunctionType>(async_function),
-                                         std::forward<CallbackType>(callback_function)));
-        cv_.notify_one();
+        Push(TaskOptions(),
+             std::forward<AsyncFunctionType>(async_function),
+             std::forward<CallbackType>(callback_function));
+    }
+
+    template<class AsyncFunctionType, class CallbackType>
+    void Push(const TaskOptions& options,
+              AsyncFunctionType&& async_function,
+              CallbackType&& callback_function) {
+        Enqueue(AsyncTaskCallable(std::forward<AsyncFunctionType>(async_function),
+                                  std::forward<CallbackType>(callback_function)),
+                options);
     }
 
     template<class AsyncFunctionType, class CallbackType>
     void Push(AsyncFunctionType&& async_function,
               CallbackType&& callback_function,
               AsyncGroup* group) {
-        std::lock_guard<std::mutex> lock(mtx_);
-        tasks_.emplace(AsyncTaskCallable(std::forward<AsyncFunctionType>(async_function),
-                                         std::forward<CallbackType>(callback_function)));
-        tasks_.back().group = group;
-        cv_.notify_one();
+        Push(TaskOptions(),
+             std::forward<AsyncFunctionType>(async_function),
+             std::forward<CallbackType>(callback_function),
+             group);
+    }
+
+    template<class AsyncFunctionType, class CallbackType>
+    void Push(const TaskOptions& options,
+              AsyncFunctionType&& async_function,
+              CallbackType&& callback_function,
+              AsyncGroup* group) {
+        AsyncTaskCallable task(std::forward<AsyncFunctionType>(async_function),
+                               std::forward<CallbackType>(callback_function));
+        task.group = group;
+        Enqueue(std::move(task), options);
     }
     void Push(AsyncGroup* group);
+    void Execute(std::function<void()>&& task) override;
+    // 提交由调用方持有内存的任务节点, 线程池已停止时立即调用node->Discard()
+    void PushNode(TaskNode* node);
     void Stop();
     void Wait();
+    // 工作线程数, 延迟启动时包括尚未创建的工作线程
+    size_t Size() const { return workers_.size(); }
+
+    /**
+     * @brief 在弹性的阻塞线程池中执行任务, 用于阻塞的系统调用或长时间持有锁的任务, 不占用计算线程
+     */
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> PushBlocking(AsyncFunctionType&& async_function) {
+        return blocking_pool_.Push(std::forward<AsyncFunctionType>(async_function));
+    }
+
+    // 当前正在补偿阻塞工作线程的线程数
+    int ActiveSpareCount() const { return active_spares_.load(); }
+
+    // 当前线程在本线程池中的工作线程序号, 从0开始, 不是本线程池的工作线程时返回-1
+    int WorkerIndex() const { return CurrentWorkerIndex(this); }
+
+    /**
+     * @brief 注册一个每个工作线程一份的对象, 返回的引用在线程池销毁前一直有效
+     *
+     * 对象在工作线程第一次调用Get时创建, 在Stop之后工作线程退出前由该线程销毁, Wait返回时已全部销毁.
+     * factory为空时使用T的默认构造函数
+     */
+    template<class T>
+    WorkerLocal<T>& Local(typename WorkerLocal<T>::Factory&& factory = nullptr,
+                          typename WorkerLocal<T>::Destroyer&& destroyer = nullptr) {
+        return locals_->Create<T>(owner_, std::move(factory), std::move(destroyer));
+    }
+
+    /**
+     * @brief 在调用线程上执行一个等待中的任务, 用于等待子任务时帮助执行而不是阻塞
+     *
+     * 工作线程优先执行本线程最新提交的任务, 然后是全局队列, 最后窃取其他工作线程的任务.
+     * 帮助执行的嵌套深度有上限, 超过上限或没有可执行的任务时返回false
+     */
+    bool RunPendingTask();
+
+private:
+    // 工作线程私有的任务队列, 工作线程内提交的任务优先放入next_slot,
+    // 被挤出的任务放入local_tasks, 其他工作线程只在空闲时才会窃取
+    struct Worker {
+        ThreadPool* pool;
+        // 作为ThreadPool2的分片时owner为ThreadPool2, index为分片序号
+        const Executor* owner;
+        int index;
+        std::mutex mtx;
+        AsyncTaskCallable next_slot;
+        std::deque<AsyncTaskCallable> local_tasks;
+        int next_slot_runs;
+        uint32_t tick;
+        // BlockingRegion的嵌套深度, 只有最外层借出槽位
+        int blocking_depth;
+        // 启用看门狗时由Watchdog::Stamp编码的当前任务, 0表示空闲
+        std::atomic<uint64_t> running;
+        // 看门狗编码中的任务序号, 只有所属工作线程访问
+        uint32_t run_sequence;
+        ProfileTable profile;
+    };
+
+    static constexpr int kMaxNextSlotRuns = 3;
+    static constexpr uint32_t kGlobalQueueInterval = 61;
+    static constexpr int kMaxHelpDepth = 256;
 
 private:
-    void WorkThread();
+    void Enqueue(AsyncTaskCallable&& task, const TaskOptions& options);
+    void EnqueueLocal(Worker* worker, AsyncTaskCallable&& task);
+    bool PopLocal(Worker* worker, AsyncTaskCallable& task);
+    bool PopLocalNewest(Worker* worker, AsyncTaskCallable& task);
+    bool PopGlobal(AsyncTaskCallable& task);
+    bool Steal(Worker* thief, AsyncTaskCallable& task);
+    bool NextTask(Worker* worker, AsyncTaskCallable& task);
+    bool Admit(AsyncTaskCallable& task);
+    void Reject(AsyncTaskCallable& task);
+    void RunTask(AsyncTaskCallable& task);
+    void FinishTask(AsyncTaskCallable& task);
+    void RecordProfile(const AsyncTaskCallable& task, uint64_t wait_ns, uint64_t wall_ns, uint64_t cpu_ns);
+    void CollectProfile(std::unordered_map<uint32_t, TagProfile>& merged);
+    void RecordFirstPush();
+    // 调用方持有mtx_, 延迟启动时在没有休眠的工作线程时再创建一个
+    void GrowIfNeeded();
+    // 调用方持有mtx_, 优先唤醒工作线程, 没有休眠的工作线程时才唤醒补偿线程
+    void NotifyOne();
+    void LaunchWorker(Worker* worker);
+    void EnterBlocking();
+    void LeaveBlocking();
+    void WorkThread(Worker* worker);
+    void SpareThread();
 
 private:
+    friend class ThreadPool2;
+    friend class BlockingRegion;
+    friend class Watchdog;
+    friend int CurrentWorkerIndex(const Executor* owner);
+
+    static thread_local Worker* current_worker_;
+    static thread_local int help_depth_;
+
     std::mutex mtx_;
     std::condition_variable cv_;
-    std::vector<std::thread> pool_;
-    std::queue<AsyncTaskCallable> tasks_;
+    std::vector<pthread_t> pool_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    WorkerThreadOptions thread_options_;
+    // 已创建线程的工作线程数, 只在mtx_保护下增加
+    std::atomic<size_t> started_workers_;
+    int64_t start_ns_;
+    // steady_clock的纳秒时间戳, 0表示尚未发生
+    std::atomic<int64_t> first_push_ns_;
+    std::atomic<int64_t> first_run_ns_;
+    TaskQueue tasks_;
+    std::atomic<size_t> local_task_count_;
+    // 休眠的工作线程数, 不包括补偿线程
+    std::atomic<int> sleeping_count_;
     std::atomic<bool> next_;
+    std::unique_ptr<AdmissionController> admission_;
+    bool profiling_;
+    // 补偿线程和帮助执行的非工作线程上执行的任务
+    ProfileTable other_profile_;
+    const Executor* owner_;
+    int index_base_;
+    std::shared_ptr<WorkerLocalRegistry> locals_;
+    // ThreadPool2的分片共用ThreadPool2的看门狗, 此时own_watchdog_为空
+    std::unique_ptr<Watchdog> own_watchdog_;
+    Watchdog* watchdog_;
+    BlockingPool blocking_pool_;
+    // 处于BlockingRegion中的工作线程数
+    std::atomic<int> lent_slots_;
+    // 正在执行任务的补偿线程数, 以下三项在mtx_保护下修改
+    std::atomic<int> active_spares_;
+    int idle_spares_;
+    int spare_wakeups_;
+    std::condition_variable spare_cv_;
+    // 没有任务可执行而休眠的补偿线程数, 与sleeping_count_分开统计, 不影响按需创建工作线程
+    std::atomic<int> sleeping_spares_;
+    std::condition_variable spare_task_cv_;
+    std::vector<pthread_t> spares_;
+};
+
+/**
+ * @brief 标记工作线程上一段会阻塞的代码
+ *
+ * 进入时当前工作线程把计算槽位借给一个补偿线程, 补偿线程从全局队列取任务或窃取任务执行,
+ * 离开时收回槽位, 补偿线程执行完手上的任务后转为空闲, 以此保持计算并行度不变.
+ * 不在ThreadPool/ThreadPool2的工作线程上时不做任何事. 补偿线程上WorkerIndex返回-1
+ *
+ * 用法:
+ *     pool.Push([]() {
+ *         atl::BlockingRegion region;
+ *         read(fd, buf, size);
+ *     });
+ */
+class BlockingRegion {
+public:
+    BlockingRegion();
+    ~BlockingRegion();
+
+    BlockingRegion(const BlockingRegion&) = delete;
+    BlockingRegion& operator=(const BlockingRegion&) = delete;
+
+private:
+    ThreadPool* pool_;
 };
 
 }
@@ -1,17 +1,127 @@
 #include "atl/utils/thread_pool2.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace atl {
 
 ThreadPool2::ThreadPool2()
     : pool_size_(0)
+    , scheduling_mode_(SchedulingMode::kFifo)
+    , admission_enabled_(false)
+    , profiling_(false)
+    , admission_target_(AdmissionController::Clock::duration::zero())
+    , admission_interval_(AdmissionController::Clock::duration::zero())
+    , start_ns_(0)
     , next_(false)
-    , index_(0) {}
+    , index_(0)
+    , locals_(std::make_shared<WorkerLocalRegistry>()) {}
 
 AsyncGroup* ThreadPool2::CreateAsyncGroup(std::function<void()>&& group_finish_callback) {
     return ThreadPool::CreateAsyncGroup(std::forward<std::function<void()>>(group_finish_callback));
 }
 
+void ThreadPool2::SetSchedulingMode(SchedulingMode mode) {
+    scheduling_mode_ = mode;
+}
+
+void ThreadPool2::EnableAdmissionControl(AdmissionController::Clock::duration target,
+                                         AdmissionController::Clock::duration interval) {
+    admission_enabled_ = true;
+    admission_target_ = target;
+    admission_interval_ = interval;
+}
+
+AdmissionController::Stats ThreadPool2::GetAdmissionStats() const {
+    AdmissionController::Stats stats{0, 0, 0, false};
+    for (auto pool : pool_) {
+        AdmissionController::Stats shard = pool->GetAdmissionStats();
+        stats.rejected += shard.rejected;
+        stats.shed += shard.shed;
+        stats.overloads += shard.overloads;
+        stats.overloaded = stats.overloaded || shard.overloaded;
+    }
+    return stats;
+}
+
+void ThreadPool2::SetTenantWeight(uint32_t tenant, uint32_t weight) {
+    tenant_weights_[tenant] = weight;
+    for (auto pool : pool_) {
+        pool->SetTenantWeight(tenant, weight);
+    }
+}
+
+std::vector<TenantStats> ThreadPool2::GetTenantStats() {
+    std::vector<TenantStats> stats;
+    for (auto pool : pool_) {
+        for (const TenantStats& shard : pool->GetTenantStats()) {
+            auto it = std::find_if(stats.begin(), stats.end(), [&shard](const TenantStats& item) {
+                return item.tenant == shard.tenant;
+            });
+            if (it == stats.end()) {
+                stats.push_back(shard);
+                continue;
+            }
+            it->queued += shard.queued;
+            it->executed += shard.executed;
+            it->wait_ns += shard.wait_ns;
+            it->cpu_ns += shard.cpu_ns;
+        }
+    }
+    return stats;
+}
+
+void ThreadPool2::SetWorkerThreadOptions(const WorkerThreadOptions& options) {
+    thread_options_ = options;
+}
+
+void ThreadPool2::EnableWatchdog(std::chrono::milliseconds threshold, Watchdog::Reporter&& reporter) {
+    watchdog_.reset(new Watchdog(threshold, std::move(reporter)));
+}
+
+PoolState ThreadPool2::GetState() {
+    PoolState state{0, {}};
+    for (auto pool : pool_) {
+        PoolState shard = pool->GetState();
+        state.global_queue += shard.global_queue;
+        state.workers.insert(state.workers.end(), shard.workers.begin(), shard.workers.end());
+    }
+    return state;
+}
+
+void ThreadPool2::EnableProfiling() {
+    profiling_ = true;
+}
+
+std::vector<TagProfile> ThreadPool2::GetProfile(size_t top_n) {
+    std::unordered_map<uint32_t, TagProfile> merged;
+    for (auto pool : pool_) {
+        pool->CollectProfile(merged);
+    }
+    return TopProfiles(merged, top_n);
+}
+
+void ThreadPool2::ResetProfile() {
+    for (auto pool : pool_) {
+        pool->ResetProfile();
+    }
+}
+
+StartupStats ThreadPool2::GetStartupStats() const {
+    StartupStats stats{0, start_ns_, -1};
+    for (auto pool : pool_) {
+        StartupStats shard = pool->GetStartupStats();
+        stats.started_workers += shard.started_workers;
+        if (shard.first_task_latency_ns >= 0 &&
+            (stats.first_task_latency_ns < 0 || shard.first_task_latency_ns < stats.first_task_latency_ns)) {
+            stats.first_task_latency_ns = shard.first_task_latency_ns;
+        }
+    }
+    return stats;
+}
+
 void ThreadPool2::Start(int pool_size) {
+    auto start = std::chrono::steady_clock::now();
     if (pool_size <= 0) {
         pool_size = static_cast<int>(std::thread::hardware_concurrency());
     }
@@ -19,20 +129,64 @@ void ThreadPool2::Start(int pool_size) {
     next_.store(true);
     index_.store(0);
     pool_size_ = static_cast<uint64_t>(pool_size);
+    locals_->SetWorkerCount(pool_size_);
     for (int i = 0; i < pool_size; i++) {
-        pool_.push_back(new ThreadPool());
+        ThreadPool* pool = new ThreadPool();
+        pool->owner_ = this;
+        pool->index_base_ = i;
+        pool->locals_ = locals_;
+        pool_.push_back(pool);
     }
     for (auto pool : pool_) {
+        pool->SetSchedulingMode(scheduling_mode_);
+        for (auto& item : tenant_weights_) {
+            pool->SetTenantWeight(item.first, item.second);
+        }
+        if (admission_enabled_) {
+            pool->EnableAdmissionControl(admission_target_, admission_interval_);
+        }
+        pool->SetWorkerThreadOptions(thread_options_);
+        if (profiling_) {
+            pool->EnableProfiling();
+        }
+        if (watchdog_) {
+            pool->watchdog_ = watchdog_.get();
+            watchdog_->Watch(pool);
+        }
         pool->Start(1);
     }
+    if (watchdog_) {
+        watchdog_->Start();
+    }
+    start_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
 }
 
 void ThreadPool2::Push(AsyncGroup* group) {
     AsyncGroupImpl* impl = static_cast<AsyncGroupImpl*>(group);
-    for (auto& pair : impl->task_list) {
+    for (auto& item : impl->task_list) {
         ThreadPool* pool = pool_[index_.fetch_add(1) % pool_size_];
-        pool->Push(std::move(pair.first), std::move(pair.second), group);
+        pool->Push(item.options, std::move(item.async_function), std::move(item.finish_callback), group);
+    }
+}
+
+void ThreadPool2::Execute(std::function<void()>&& task) {
+    Push(std::move(task), [](){});
+}
+
+void ThreadPool2::Execute(uint64_t shard, std::function<void()>&& task) {
+    // 分片的工作线程内提交时也要进入全局队列, 否则会插到已排队的任务前面
+    TaskOptions options;
+    options.ordered = true;
+    pool_[shard % pool_size_]->Push(options, std::move(task), [](){});
+}
+
+void ThreadPool2::PushNode(TaskNode* node) {
+    if (pool_.empty()) {
+        node->Discard();
+        return;
     }
+    pool_[index_.fetch_add(1) % pool_size_]->PushNode(node);
 }
 
 void ThreadPool2::Stop() {
@@ -40,6 +194,9 @@ void ThreadPool2::Stop() {
     for (auto pool : pool_) {
         pool->Stop();
     }
+    if (watchdog_) {
+        watchdog_->Stop();
+    }
 }
 
 void ThreadPool2::Wait() {
@@ -4,42 +4,116 @@
 
 namespace atl {
 
-class ThreadPool2 {
+class ThreadPool2 : public Executor {
 public:
     static AsyncGroup* CreateAsyncGroup(std::function<void()>&& group_finish_callback = nullptr);
 
 public:
     ThreadPool2();
     bool IsStopped() const { return !next_; }
+    // 必须在Start之前调用, 对每个分片单独生效
+    void SetSchedulingMode(SchedulingMode mode);
+    // 必须在Start之前调用, 每个分片按自己的排队时间单独判断是否过载
+    void EnableAdmissionControl(AdmissionController::Clock::duration target = std::chrono::milliseconds(5),
+                                AdmissionController::Clock::duration interval = std::chrono::milliseconds(100));
+    // 所有分片的统计之和, 任一分片过载时overloaded为true
+    AdmissionController::Stats GetAdmissionStats() const;
+    // 每个分片单独按租户公平调度, 权重在Start之前设置时在Start时生效
+    void SetTenantWeight(uint32_t tenant, uint32_t weight);
+    // 所有分片的统计之和
+    std::vector<TenantStats> GetTenantStats();
+    // 必须在Start之前调用, 延迟启动时每个分片在第一次收到任务时才创建线程
+    void SetWorkerThreadOptions(const WorkerThreadOptions& options);
+    // 所有分片共用一个看门狗线程, 必须在Start之前调用
+    void EnableWatchdog(std::chrono::milliseconds threshold, Watchdog::Reporter&& reporter = nullptr);
+    // global_queue为所有分片的队列长度之和
+    PoolState GetState();
+    std::string DumpState() { return FormatPoolState(GetState()); }
+    // 必须在Start之前调用, 对每个分片生效
+    void EnableProfiling();
+    // 合并所有分片的统计, 用法同ThreadPool::GetProfile
+    std::vector<TagProfile> GetProfile(size_t top_n = 0);
+    void ResetProfile();
+    // started_workers为所有分片之和, first_task_latency_ns取最先执行任务的分片
+    StartupStats GetStartupStats() const;
     void Start(int pool_size = 0);
+    uint64_t Size() const { return pool_size_; }
 
     template<class AsyncFunctionType>
     std::future<typename std::result_of<AsyncFunctionType()>::type> Push(AsyncFunctionType&& async_function) {
+        return Push(TaskOptions(), std::forward<AsyncFunctionType>(async_function));
+    }
+
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> Push(const TaskOptions& options,
+                                                                        AsyncFunctionType&& async_function) {
         uint64_t index = index_.fetch_add(1) % pool_size_;
         ThreadPool* pool = pool_[index];
-        return pool->Push<AsyncFunctionType>(std::forward<AsyncFunctionType>(async_function));
+        return pool->Push(options, std::forward<AsyncFunctionType>(async_function));
     }
 
-    template<class AsyncFunctionType, class CallbackType>
+    template<class AsyncFunctionType, class CallbackType, EnableIfNotTaskOptions<AsyncFunctionType> = 0>
     void Push(AsyncFunctionType&& async_function,
               CallbackType&& callback_function) {
+        Push(TaskOptions(),
+             std::forward<AsyncFunctionType>(async_function),
+             std::forward<CallbackType>(callback_function));
+    }
+
+    template<class AsyncFunctionType, class CallbackType>
+    void Push(const TaskOptions& options,
+              AsyncFunctionType&& async_function,
+              CallbackType&& callback_function) {
         uint64_t index = index_.fetch_add(1) % pool_size_;
         ThreadPool* pool = pool_[index];
-        pool->Push(std::forward<AsyncFunctionType>(async_function),
-                  std::forward<CallbackType>(callback_function));
+        pool->Push(options,
+                   std::forward<AsyncFunctionType>(async_function),
+                   std::forward<CallbackType>(callback_function));
+    }
+    // 在弹性的阻塞线程池中执行任务, 用法同ThreadPool::PushBlocking
+    template<class AsyncFunctionType>
+    std::future<typename std::result_of<AsyncFunctionType()>::type> PushBlocking(AsyncFunctionType&& async_function) {
+        return pool_[0]->PushBlocking(std::forward<AsyncFunctionType>(async_function));
     }
+
     void Push(AsyncGroup* group);
+    void Execute(std::function<void()>&& task) override;
+    // 提交到指定分片, 不论在哪个线程上提交, 同一分片上的任务都按提交顺序开始执行.
+    // 分片只有一个工作线程, 但任务进入BlockingRegion时分片会启动补偿线程, 之后的任务可能与阻塞中的任务并发执行
+    void Execute(uint64_t shard, std::function<void()>&& task);
+    // 轮询提交到一个分片, 用法同ThreadPool::PushNode
+    void PushNode(TaskNode* node);
     void Stop();
     void Wait();
 
+    // 当前线程所在的分片序号, 不是本线程池的工作线程时返回-1
+    int WorkerIndex() const { return CurrentWorkerIndex(this); }
+
+    // 每个分片一份的对象, 用法同ThreadPool::Local
+    template<class T>
+    WorkerLocal<T>& Local(typename WorkerLocal<T>::Factory&& factory = nullptr,
+                          typename WorkerLocal<T>::Destroyer&& destroyer = nullptr) {
+        return locals_->Create<T>(this, std::move(factory), std::move(destroyer));
+    }
+
 private:
     void WorkThread();
 
 private:
     uint64_t pool_size_;
+    SchedulingMode scheduling_mode_;
+    bool admission_enabled_;
+    bool profiling_;
+    AdmissionController::Clock::duration admission_target_;
+    AdmissionController::Clock::duration admission_interval_;
+    std::unordered_map<uint32_t, uint32_t> tenant_weights_;
+    WorkerThreadOptions thread_options_;
+    int64_t start_ns_;
+    std::unique_ptr<Watchdog> watchdog_;
     std::atomic<bool> next_;
     std::atomic<uint64_t> index_;
     std::vector<ThreadPool*> pool_;
+    std::shared_ptr<WorkerLocalRegistry> locals_;
 };
 
 }
@@ -0,0 +1,86 @@
+#include "atl/utils/timer_queue.h"
+
+namespace atl {
+
+TimerQueue& TimerQueue::Default() {
+    // 不析构, 避免进程退出时其他静态对象仍在使用
+    static TimerQueue* queue = new TimerQueue();
+    return *queue;
+}
+
+TimerQueue::TimerQueue()
+    : next_id_(1)
+    , stopped_(false) {
+    thread_ = std::thread(&TimerQueue::Run, this);
+}
+
+TimerQueue::~TimerQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+        cv_.notify_all();
+    }
+    thread_.join();
+}
+
+uint64_t TimerQueue::Schedule(Clock::time_point when, std::function<void()>&& callback) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint64_t id = next_id_++;
+    bool earliest = timers_.empty() || Key(when, id) < timers_.begin()->first;
+    timers_.emplace(Key(when, id), std::move(callback));
+    ids_.emplace(id, when);
+    if (earliest) {
+        cv_.notify_one();
+    }
+    return id;
+}
+
+uint64_t TimerQueue::Schedule(Clock::duration delay, std::function<void()>&& callback) {
+    return Schedule(Clock::now() + delay, std::move(callback));
+}
+
+bool TimerQueue::Cancel(uint64_t id) {
+    std::function<void()> callback;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto iter = ids_.find(id);
+        if (iter == ids_.end()) {
+            return false;
+        }
+        auto timer = timers_.find(Key(iter->second, id));
+        callback = std::move(timer->second);
+        timers_.erase(timer);
+        ids_.erase(iter);
+    }
+    // 在锁外析构回调函数, 回调函数持有的对象析构时可能再次调用TimerQueue
+    return true;
+}
+
+size_t TimerQueue::Size() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return timers_.size();
+}
+
+void TimerQueue::Run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stopped_) {
+        if (timers_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto iter = timers_.begin();
+        if (Clock::now() < iter->first.first) {
+            cv_.wait_until(lock, iter->first.first);
+            continue;
+        }
+        std::function<void()> callback = std::move(iter->second);
+        ids_.erase(iter->first.second);
+        timers_.erase(iter);
+        lock.unlock();
+        callback();
+        callback = nullptr;
+        lock.lock();
+    }
+}
+
+}
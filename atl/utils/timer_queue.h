@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace atl {
+
+/**
+ * @brief 单线程定时器队列
+ *
+ * 回调函数在定时器线程上执行, 应当尽快返回, 耗时的工作应当提交到线程池.
+ * Default()返回进程共享的实例, 第一次使用时才创建线程
+ */
+class TimerQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static TimerQueue& Default();
+
+public:
+    TimerQueue();
+    ~TimerQueue();
+
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    /**
+     * @brief 在指定时间点执行回调函数
+     *
+     * @return uint64_t 定时器id, 用于取消
+     */
+    uint64_t Schedule(Clock::time_point when, std::function<void()>&& callback);
+    uint64_t Schedule(Clock::duration delay, std::function<void()>&& callback);
+    /**
+     * @brief 取消尚未执行的定时器
+     *
+     * @return bool 定时器已经执行或正在执行时返回false
+     */
+    bool Cancel(uint64_t id);
+    size_t Size();
+
+private:
+    void Run();
+
+private:
+    using Key = std::pair<Clock::time_point, uint64_t>;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::map<Key, std::function<void()>> timers_;
+    std::unordered_map<uint64_t, Clock::time_point> ids_;
+    uint64_t next_id_;
+    bool stopped_;
+    std::thread thread_;
+};
+
+}
@@ -0,0 +1,120 @@
+#include "atl/utils/watchdog.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "atl/utils/thread_pool.h"
+
+namespace atl {
+
+namespace {
+
+void ReportToStderr(const WorkerState& worker) {
+    fprintf(stderr, "atl watchdog: worker %d has been running task [%s] for %lldms\n",
+            worker.index, worker.tag.Name(), static_cast<long long>(worker.running_time.count()));
+}
+
+}
+
+std::string FormatPoolState(const PoolState& state) {
+    std::string text = "global queue: " + std::to_string(state.global_queue) + "\n";
+    for (const WorkerState& worker : state.workers) {
+        text += "worker " + std::to_string(worker.index) + ": ";
+        if (worker.running) {
+            text += "running [" + std::string(worker.tag.Name()) + "] for " +
+                    std::to_string(worker.running_time.count()) + "ms";
+        } else {
+            text += "idle";
+        }
+        text += ", local queue: " + std::to_string(worker.local_queue) + "\n";
+    }
+    return text;
+}
+
+Watchdog::Watchdog(std::chrono::milliseconds threshold, Reporter&& reporter)
+    : threshold_(threshold)
+    , interval_(std::min(std::max(threshold / 4, std::chrono::milliseconds(1)), std::chrono::milliseconds(100)))
+    , reporter_(reporter ? std::move(reporter) : Reporter(&ReportToStderr))
+    , epoch_(std::chrono::steady_clock::now())
+    , now_ms_(0)
+    , running_(false) {}
+
+Watchdog::~Watchdog() {
+    Stop();
+}
+
+void Watchdog::Watch(ThreadPool* pool) {
+    pools_.push_back(pool);
+}
+
+void Watchdog::Start() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    reported_.clear();
+    for (ThreadPool* pool : pools_) {
+        reported_.emplace_back(pool->workers_.size(), 0);
+    }
+    thread_ = std::thread(&Watchdog::Loop, this);
+}
+
+void Watchdog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+WorkerState Watchdog::Decode(int index, uint64_t stamp, size_t local_queue) const {
+    WorkerState state{index, stamp != 0, std::chrono::milliseconds(0), TaskTag(), local_queue};
+    if (stamp != 0) {
+        // 时钟按2^32取模, 相减后同样取模, 任务运行不超过49天时结果正确
+        uint64_t start_ms = stamp >> 32;
+        uint64_t now_ms = (now_ms_.load(std::memory_order_relaxed) & 0xffffffff) | 1;
+        state.running_time = std::chrono::milliseconds((now_ms - start_ms) & 0xffffffff);
+        state.tag = TaskTag::FromId(static_cast<uint32_t>(stamp & (TaskTag::kMaxTags - 1)));
+    }
+    return state;
+}
+
+void Watchdog::Loop() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (running_) {
+        cv_.wait_for(lock, interval_);
+        if (!running_) {
+            break;
+        }
+        now_ms_.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - epoch_).count()), std::memory_order_relaxed);
+        for (size_t i = 0; i < pools_.size(); i++) {
+            ThreadPool* pool = pools_[i];
+            for (size_t j = 0; j < pool->workers_.size(); j++) {
+                ThreadPool::Worker* worker = pool->workers_[j].get();
+                uint64_t stamp = worker->running.load(std::memory_order_relaxed);
+                if (stamp == 0 || stamp == reported_[i][j]) {
+                    continue;
+                }
+                WorkerState state = Decode(worker->index, stamp, 0);
+                if (state.running_time < threshold_) {
+                    continue;
+                }
+                reported_[i][j] = stamp;
+                {
+                    std::lock_guard<std::mutex> worker_lock(worker->mtx);
+                    state.local_queue = worker->local_tasks.size() + (worker->next_slot.Empty() ? 0 : 1);
+                }
+                lock.unlock();
+                reporter_(state);
+                lock.lock();
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/task_tag.h"
+
+namespace atl {
+
+class ThreadPool;
+
+struct WorkerState {
+    // 工作线程序号, ThreadPool2中为分片序号
+    int index;
+    bool running;
+    // 当前任务已执行的时长, 精度为看门狗的检查间隔
+    std::chrono::milliseconds running_time;
+    TaskTag tag;
+    // 本线程队列中等待的任务数
+    size_t local_queue;
+};
+
+struct PoolState {
+    // 全局队列中等待的任务数, ThreadPool2中为所有分片之和
+    size_t global_queue;
+    std::vector<WorkerState> workers;
+};
+
+// 每行一个工作线程的文本格式
+std::string FormatPoolState(const PoolState& state);
+
+/**
+ * @brief 卡住任务的看门狗, 由ThreadPool::EnableWatchdog/ThreadPool2::EnableWatchdog创建
+ *
+ * 工作线程每开始一个任务做一次relaxed store, 把开始时间, 运行序号和任务标签编码到一个64位整数中:
+ * 高32位为看门狗的粗粒度时钟(毫秒, 按2^32取模, 最低位置1保证非0), 中间8位为工作线程的任务序号, 低24位为标签编号, 0表示空闲.
+ * 序号使同一个时钟周期内开始的同标签任务得到不同的编码, 后一个卡住时不会被当作已经报告过的任务.
+ * 粗粒度时钟由看门狗线程每个检查间隔更新一次, 工作线程不需要读取系统时钟.
+ * 看门狗线程发现执行时间超过阈值的任务时调用一次reporter, 同一个任务不会重复报告
+ */
+class Watchdog {
+public:
+    using Reporter = std::function<void(const WorkerState& worker)>;
+
+public:
+    // reporter为空时输出到stderr
+    Watchdog(std::chrono::milliseconds threshold, Reporter&& reporter);
+    ~Watchdog();
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    // 必须在Start之前调用
+    void Watch(ThreadPool* pool);
+    void Start();
+    void Stop();
+
+    // sequence为工作线程每个任务递增的计数, 只使用低8位
+    uint64_t Stamp(TaskTag tag, uint32_t sequence) const {
+        uint64_t now_ms = (now_ms_.load(std::memory_order_relaxed) & 0xffffffff) | 1;
+        return (now_ms << 32) | (static_cast<uint64_t>(sequence & 0xff) << 24) | tag.Id();
+    }
+    WorkerState Decode(int index, uint64_t stamp, size_t local_queue) const;
+
+private:
+    void Loop();
+
+private:
+    std::chrono::milliseconds threshold_;
+    std::chrono::milliseconds interval_;
+    Reporter reporter_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::atomic<uint64_t> now_ms_;
+    std::vector<ThreadPool*> pools_;
+    // 每个工作线程最后一次报告的任务
+    std::vector<std::vector<uint64_t>> reported_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool running_;
+    std::thread thread_;
+};
+
+}
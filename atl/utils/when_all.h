@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "atl/utils/cancellation.h"
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+template<class T>
+struct WhenAnyResult {
+    // 胜出的函数在参数中的序号
+    size_t index;
+    T value;
+};
+
+/**
+ * @brief 把所有函数提交到执行器, 全部完成后通过回调或future交付按提交顺序排列的结果
+ *
+ * 每个结果写入按缓存行隔开的槽位, 完成计数用一个原子变量, 最后完成的任务负责交付, 不占用等待线程.
+ * 任一函数抛出异常时交付第一个异常, 其余函数仍会执行完
+ *
+ * 用法:
+ *     std::future<std::vector<Reply>> replies = atl::WhenAll<Reply>(pool, {
+ *         [&]() { return Query(shard0); },
+ *         [&]() { return Query(shard1); },
+ *     });
+ */
+template<class T>
+void WhenAll(Executor& executor,
+             std::vector<std::function<T()>>&& functions,
+             std::function<void(std::vector<T>&& results, std::exception_ptr error)>&& callback) {
+    struct alignas(64) Slot {
+        std::optional<T> value;
+    };
+    struct State {
+        std::vector<std::function<T()>> functions;
+        std::vector<Slot> slots;
+        std::function<void(std::vector<T>&&, std::exception_ptr)> callback;
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+
+        void Arrive() {
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            std::vector<T> results;
+            if (!failed.load()) {
+                results.reserve(slots.size());
+                for (auto& slot : slots) {
+                    results.push_back(std::move(*slot.value));
+                }
+            }
+            callback(std::move(results), error);
+        }
+    };
+
+    size_t count = functions.size();
+    if (count == 0) {
+        callback(std::vector<T>(), nullptr);
+        return;
+    }
+    auto state = std::make_shared<State>();
+    state->functions = std::move(functions);
+    state->slots.resize(count);
+    state->callback = std::move(callback);
+    state->remaining.store(count);
+    state->failed.store(false);
+    for (size_t i = 0; i < count; i++) {
+        executor.Execute([state, i]() {
+            try {
+                state->slots[i].value.emplace(state->functions[i]());
+            } catch (...) {
+                if (!state->failed.exchange(true)) {
+                    state->error = std::current_exception();
+                }
+            }
+            state->Arrive();
+        });
+    }
+}
+
+template<class T>
+std::future<std::vector<T>> WhenAll(Executor& executor, std::vector<std::function<T()>>&& functions) {
+    auto promise = std::make_shared<std::promise<std::vector<T>>>();
+    std::future<std::vector<T>> future = promise->get_future();
+    WhenAll<T>(executor, std::move(functions), [promise](std::vector<T>&& results, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(results));
+        }
+    });
+    return future;
+}
+
+/**
+ * @brief 把所有函数提交到执行器, 第一个正常返回的函数胜出, 通过回调或future交付它的序号和结果
+ *
+ * 胜出后取消传给所有函数的CancellationToken: 还没开始执行的函数直接跳过,
+ * 正在执行的函数可以检查令牌尽早返回, 它们的结果被丢弃. 用于对冲请求时, 慢的副本不会继续占用线程.
+ * 所有函数都抛出异常时交付最后一个异常; 没有函数时交付std::invalid_argument
+ *
+ * 用法:
+ *     std::future<atl::WhenAnyResult<Reply>> reply = atl::WhenAny<Reply>(pool, {
+ *         [&](const atl::CancellationToken& token) { return Query(replica0, token); },
+ *         [&](const atl::CancellationToken& token) { return Query(replica1, token); },
+ *     });
+ */
+template<class T>
+void WhenAny(Executor& executor,
+             std::vector<std::function<T(const CancellationToken&)>>&& functions,
+             std::function<void(std::optional<WhenAnyResult<T>>&& result, std::exception_ptr error)>&& callback) {
+    struct State {
+        std::vector<std::function<T(const CancellationToken&)>> functions;
+        std::function<void(std::optional<WhenAnyResult<T>>&&, std::exception_ptr)> callback;
+        CancellationSource source;
+        std::atomic<bool> finished;
+        std::atomic<size_t> failures;
+    };
+
+    size_t count = functions.size();
+    if (count == 0) {
+        callback(std::nullopt, std::make_exception_ptr(std::invalid_argument("WhenAny requires at least one function")));
+        return;
+    }
+    auto state = std::make_shared<State>();
+    state->functions = std::move(functions);
+    state->callback = std::move(callback);
+    state->finished.store(false);
+    state->failures.store(0);
+    CancellationToken token = state->source.Token();
+    for (size_t i = 0; i < count; i++) {
+        executor.Execute([state, token, i, count]() {
+            if (token.IsCancellationRequested()) {
+                return;
+            }
+            std::optional<T> value;
+            std::exception_ptr error;
+            try {
+                value.emplace(state->functions[i](token));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            if (value) {
+                if (!state->finished.exchange(true)) {
+                    state->source.Cancel();
+                    state->callback(WhenAnyResult<T>{i, std::move(*value)}, nullptr);
+                }
+                return;
+            }
+            // 只有没有胜出者时所有函数都会走到这里, 最后一个失败的函数负责交付异常
+            if (state->failures.fetch_add(1, std::memory_order_acq_rel) + 1 == count &&
+                !state->finished.exchange(true)) {
+                state->callback(std::nullopt, error);
+            }
+        });
+    }
+}
+
+template<class T>
+std::future<WhenAnyResult<T>> WhenAny(Executor& executor,
+                                      std::vector<std::function<T(const CancellationToken&)>>&& functions) {
+    auto promise = std::make_shared<std::promise<WhenAnyResult<T>>>();
+    std::future<WhenAnyResult<T>> future = promise->get_future();
+    WhenAny<T>(executor, std::move(functions),
+               [promise](std::optional<WhenAnyResult<T>>&& result, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(*result));
+        }
+    });
+    return future;
+}
+
+}
@@ -0,0 +1,25 @@
+#include "atl/utils/worker_local.h"
+
+namespace atl {
+
+WorkerLocalBase::~WorkerLocalBase() {}
+
+WorkerLocalRegistry::WorkerLocalRegistry()
+    : worker_count_(0) {}
+
+void WorkerLocalRegistry::SetWorkerCount(size_t worker_count) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    worker_count_ = worker_count;
+    for (auto& local : locals_) {
+        local->Resize(worker_count);
+    }
+}
+
+void WorkerLocalRegistry::DestroyWorker(size_t index) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& local : locals_) {
+        local->Destroy(index);
+    }
+}
+
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "atl/utils/executor.h"
+
+namespace atl {
+
+/**
+ * @brief 当前线程在owner中的工作线程序号, 不是owner的工作线程时返回-1
+ *
+ * owner为ThreadPool或ThreadPool2, ThreadPool2的序号即分片序号
+ */
+int CurrentWorkerIndex(const Executor* owner);
+
+class WorkerLocalBase {
+public:
+    virtual ~WorkerLocalBase();
+    virtual void Resize(size_t worker_count) = 0;
+    // 由工作线程在退出前调用, 销毁本线程的对象
+    virtual void Destroy(size_t index) = 0;
+};
+
+/**
+ * @brief 每个工作线程一份的对象, 在工作线程第一次调用Get时通过工厂函数创建,
+ *        在工作线程退出前由该线程自己销毁, 销毁前调用destroyer
+ */
+template<class T>
+class WorkerLocal : public WorkerLocalBase {
+public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+    using Destroyer = std::function<void(T&)>;
+
+public:
+    WorkerLocal(const Executor* owner, Factory&& factory, Destroyer&& destroyer)
+        : owner_(owner)
+        , factory_(std::move(factory))
+        , destroyer_(std::move(destroyer)) {
+        if (!factory_) {
+            factory_ = []() { return std::unique_ptr<T>(new T()); };
+        }
+    }
+
+    /**
+     * @brief 返回当前工作线程的对象, 不在所属线程池的工作线程上调用时返回nullptr
+     */
+    T* Get() {
+        int index = CurrentWorkerIndex(owner_);
+        if (index < 0) {
+            return nullptr;
+        }
+        Slot& slot = slots_[index];
+        if (!slot.value) {
+            slot.value = factory_();
+        }
+        return slot.value.get();
+    }
+
+    void Resize(size_t worker_count) override {
+        if (slots_.size() < worker_count) {
+            slots_.resize(worker_count);
+        }
+    }
+
+    void Destroy(size_t index) override {
+        if (index >= slots_.size() || !slots_[index].value) {
+            return;
+        }
+        if (destroyer_) {
+            destroyer_(*slots_[index].value);
+        }
+        slots_[index].value.reset();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::unique_ptr<T> value;
+    };
+
+private:
+    const Executor* owner_;
+    Factory factory_;
+    Destroyer destroyer_;
+    std::vector<Slot> slots_;
+};
+
+/**
+ * @brief 线程池持有的所有WorkerLocal对象
+ */
+class WorkerLocalRegistry {
+public:
+    WorkerLocalRegistry();
+
+    void SetWorkerCount(size_t worker_count);
+
+    template<class T>
+    WorkerLocal<T>& Create(const Executor* owner,
+                           typename WorkerLocal<T>::Factory&& factory,
+                           typename WorkerLocal<T>::Destroyer&& destroyer) {
+        auto local = std::make_unique<WorkerLocal<T>>(owner, std::move(factory), std::move(destroyer));
+        WorkerLocal<T>& result = *local;
+        std::lock_guard<std::mutex> lock(mtx_);
+        local->Resize(worker_count_);
+        locals_.push_back(std::move(local));
+        return result;
+    }
+
+    void DestroyWorker(size_t index);
+
+private:
+    std::mutex mtx_;
+    size_t worker_count_;
+    std::vector<std::unique_ptr<WorkerLocalBase>> locals_;
+};
+
+}
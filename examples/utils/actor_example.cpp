@@ -0,0 +1,93 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <malloc.h>
+
+#include "atl/utils/actor.h"
+#include "atl/utils/slab_allocator.h"
+#include "atl/utils/thread_pool2.h"
+
+size_t MallocInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.arena + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+struct Session {
+    uint64_t bytes = 0;
+    uint32_t requests = 0;
+};
+
+// 用法: actor_example [actor_count] [messages_per_actor] [thread_count]
+int main(int argc, char* argv[]) {
+    int actor_count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int message_count = argc > 2 ? std::atoi(argv[2]) : 10;
+    int thread_count = argc > 3 ? std::atoi(argv[3]) : 0;
+
+    atl::ThreadPool2 pool;
+    pool.Start(thread_count);
+    std::atomic<long long> remaining(static_cast<long long>(actor_count) * message_count);
+    std::promise<void> done;
+
+    size_t heap_before = MallocInUse();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<atl::Actor<Session, uint32_t>>> actors;
+    actors.reserve(actor_count);
+    for (int i = 0; i < actor_count; i++) {
+        actors.emplace_back(new atl::Actor<Session, uint32_t>(pool, Session(),
+            [&remaining, &done](Session& session, uint32_t& size) {
+                session.bytes += size;
+                session.requests++;
+                if (remaining.fetch_sub(1, std::memory_order_relaxed) == 1) {
+                    done.set_value();
+                }
+            }));
+    }
+    auto created = std::chrono::steady_clock::now();
+    std::cout << "actors: " << actor_count
+              << " create: " << std::chrono::duration_cast<std::chrono::milliseconds>(created - start).count() << "ms"
+              << " heap: " << (MallocInUse() - heap_before) / actor_count << " bytes/actor" << std::endl;
+
+    for (int m = 0; m < message_count; m++) {
+        for (auto& actor : actors) {
+            actor->Send(static_cast<uint32_t>(m));
+        }
+    }
+    done.get_future().get();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - created).count();
+    double messages = static_cast<double>(actor_count) * message_count;
+    std::cout << "messages: " << static_cast<long long>(messages)
+              << " elapsed: " << elapsed << "us"
+              << " ns/message: " << elapsed * 1000.0 / messages << std::endl;
+
+    // 同一个Actor连续收到消息时, 一次调度处理一批消息
+    const int burst = 1000000;
+    remaining.store(burst);
+    done = std::promise<void>();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < burst; i++) {
+        actors[0]->Send(1);
+    }
+    done.get_future().get();
+    elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "single actor messages: " << burst
+              << " elapsed: " << elapsed << "us"
+              << " ns/message: " << elapsed * 1000.0 / burst << std::endl;
+
+    pool.Stop();
+    pool.Wait();
+    atl::SlabAllocator::Stats stats = atl::SlabAllocator::GetStats();
+    std::cout << "slab reserved: " << stats.reserved_bytes << " bytes"
+              << " used blocks: " << stats.used_blocks << std::endl;
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+#include "atl/utils/fiber.h"
+#include "atl/utils/thread_pool2.h"
+
+size_t ResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// 用法: fiber_example [fiber_count] [yields_per_fiber] [thread_count] [stack_kb] [guard_page]
+// 默认不使用保护页: 每个保护页多占用一个内存映射, 10万个纤程会超过默认的vm.max_map_count(65530)
+int main(int argc, char* argv[]) {
+    int fiber_count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int yield_count = argc > 2 ? std::atoi(argv[2]) : 10;
+    int thread_count = argc > 3 ? std::atoi(argv[3]) : 0;
+    atl::FiberOptions options;
+    options.stack_size = (argc > 4 ? std::atoi(argv[4]) : 16) * 1024;
+    options.guard_page = argc > 5 && std::atoi(argv[5]) != 0;
+
+    atl::ThreadPool2 pool;
+    pool.Start(thread_count);
+    atl::FiberScheduler scheduler(pool, options);
+    atl::FiberMutex mutex;
+    long long counter = 0;
+    size_t resident_before = ResidentBytes();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < fiber_count; i++) {
+        scheduler.Spawn([&mutex, &counter, yield_count]() {
+            // 所有纤程同时存活
+            atl::this_fiber::SleepFor(std::chrono::milliseconds(100));
+            for (int j = 0; j < yield_count; j++) {
+                atl::this_fiber::Yield();
+            }
+            mutex.Lock();
+            counter++;
+            mutex.Unlock();
+        });
+    }
+    auto spawned = std::chrono::steady_clock::now();
+    size_t live = scheduler.LiveCount();
+    size_t resident = ResidentBytes();
+    scheduler.Join();
+    auto finished = std::chrono::steady_clock::now();
+
+    atl::FiberScheduler::Stats stats = scheduler.GetStats();
+    auto spawn_us = std::chrono::duration_cast<std::chrono::microseconds>(spawned - start).count();
+    auto total_us = std::chrono::duration_cast<std::chrono::microseconds>(finished - start).count();
+    std::cout << "fibers: " << fiber_count
+              << " live after spawn: " << live
+              << " spawn: " << spawn_us << "us"
+              << " (" << spawn_us * 1000.0 / fiber_count << " ns/fiber)" << std::endl;
+    std::cout << "total: " << total_us << "us"
+              << " switches: " << stats.switches
+              << " migrations: " << stats.migrations
+              << " counter: " << counter << std::endl;
+    std::cout << "stack reserved: " << stats.stack_reserved_bytes
+              << " resident growth: " << (resident - resident_before)
+              << " (" << (resident - resident_before) / fiber_count << " bytes/fiber)" << std::endl;
+
+    // 单个纤程连续让出, 测量切换开销
+    const int switch_count = 1000000;
+    start = std::chrono::steady_clock::now();
+    scheduler.Spawn([]() {
+        for (int i = 0; i < switch_count; i++) {
+            atl::this_fiber::Yield();
+        }
+    });
+    scheduler.Join();
+    auto yield_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "yield round trip: " << yield_us * 1000.0 / switch_count << " ns" << std::endl;
+
+    pool.Stop();
+    pool.Wait();
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "atl/utils/fork_join.h"
+
+int SerialFib(int n) {
+    return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+}
+
+int ParallelFib(atl::ThreadPool& pool, int n, int cutoff) {
+    if (n < 2 || n <= cutoff) {
+        return SerialFib(n);
+    }
+    int x = 0;
+    atl::ForkJoinGroup group(pool);
+    group.Spawn([&pool, &x, n, cutoff]() { x = ParallelFib(pool, n - 1, cutoff); });
+    int y = ParallelFib(pool, n - 2, cutoff);
+    group.Sync();
+    return x + y;
+}
+
+// 用法: fork_join_example [n] [cutoff]
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? std::atoi(argv[1]) : 35;
+    int cutoff = argc > 2 ? std::atoi(argv[2]) : 0;
+    int max_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        atl::ThreadPool pool;
+        pool.Start(threads);
+        auto start = std::chrono::steady_clock::now();
+        int result = pool.Push([&pool, n, cutoff]() { return ParallelFib(pool, n, cutoff); }).get();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "threads: " << threads << " fib(" << n << ") = " << result
+                  << " elapsed: " << elapsed << "ms" << std::endl;
+        pool.Stop();
+        pool.Wait();
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/pipeline.h"
+#include "atl/utils/thread_pool.h"
+
+struct Record {
+    int id = 0;
+    std::string raw;
+    std::vector<int> fields;
+    std::string compressed;
+};
+
+void Parse(Record& record) {
+    record.raw = std::string(256, static_cast<char>('a' + record.id % 26));
+    for (size_t i = 0; i < record.raw.size(); i += 16) {
+        record.fields.push_back(record.raw[i] + static_cast<int>(i));
+    }
+}
+
+void Transform(Record& record) {
+    for (int& field : record.fields) {
+        for (int i = 0; i < 200; i++) {
+            field = field * 31 + i;
+        }
+    }
+}
+
+void Compress(Record& record) {
+    for (int field : record.fields) {
+        record.compressed.push_back(static_cast<char>(field & 0x7f));
+    }
+}
+
+const int kRecordCount = 200000;
+
+// 每个阶段一个线程池, 阶段之间用无界队列连接: 下游慢时元素在内存中堆积, 写入顺序也不确定
+void RunThreadPools() {
+    atl::ThreadPool parse;
+    atl::ThreadPool transform;
+    atl::ThreadPool compress;
+    atl::ThreadPool write;
+    parse.Start(1);
+    transform.Start(2);
+    compress.Start(2);
+    write.Start(1);
+    std::atomic<int> in_flight(0);
+    int max_in_flight = 0;
+    int out_of_order = 0;
+    int last_id = -1;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRecordCount; i++) {
+        max_in_flight = std::max(max_in_flight, ++in_flight);
+        parse.Push([&, i]() {
+            auto record = std::make_shared<Record>();
+            record->id = i;
+            Parse(*record);
+            transform.Push([&, record]() {
+                Transform(*record);
+                compress.Push([&, record]() {
+                    Compress(*record);
+                    write.Push([&, record]() {
+                        out_of_order += record->id < last_id ? 1 : 0;
+                        last_id = record->id;
+                        in_flight--;
+                    });
+                });
+            });
+        });
+    }
+    while (in_flight.load() != 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto finished = std::chrono::steady_clock::now();
+    std::cout << "thread pools: " << std::chrono::duration_cast<std::chrono::milliseconds>(finished - start).count()
+              << "ms max in flight: " << max_in_flight << " out of order: " << out_of_order << std::endl;
+    for (auto* pool : {&parse, &transform, &compress, &write}) {
+        pool->Stop();
+        pool->Wait();
+    }
+}
+
+// 有界队列连接的流水线: 在途元素不超过队列容量之和, 并行阶段之后保持输入顺序
+void RunPipeline() {
+    int out_of_order = 0;
+    int last_id = -1;
+    atl::Pipeline<Record> pipeline(256);
+    pipeline.AddSerialStage("parse", Parse)
+            .AddParallelStage("transform", 2, Transform)
+            .AddParallelStage("compress", 2, Compress)
+            .AddSerialStage("write", [&](Record& record) {
+                out_of_order += record.id < last_id ? 1 : 0;
+                last_id = record.id;
+            });
+    auto start = std::chrono::steady_clock::now();
+    pipeline.Start();
+    for (int i = 0; i < kRecordCount; i++) {
+        Record record;
+        record.id = i;
+        pipeline.Push(std::move(record));
+    }
+    pipeline.Close();
+    auto finished = std::chrono::steady_clock::now();
+    std::cout << "pipeline: " << std::chrono::duration_cast<std::chrono::milliseconds>(finished - start).count()
+              << "ms max in flight: <= " << 4 * 256 + 6 << " out of order: " << out_of_order << std::endl;
+    for (auto& stage : pipeline.GetStats()) {
+        std::cout << "  " << stage.name << " x" << stage.concurrency
+                  << " processed: " << stage.processed
+                  << " throughput: " << static_cast<uint64_t>(stage.throughput) << "/s"
+                  << " busy: " << stage.busy_ns / 1000000 << "ms"
+                  << " input wait: " << stage.input_wait_ns / 1000000 << "ms"
+                  << " output wait: " << stage.output_wait_ns / 1000000 << "ms" << std::endl;
+    }
+}
+
+int main() {
+    RunThreadPools();
+    RunPipeline();
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+
+#include "atl/utils/slab_allocator.h"
+
+struct MallocPolicy {
+    static const char* Name() { return "malloc"; }
+    static void* Allocate(size_t size) { return std::malloc(size); }
+    static void Free(void* ptr) { std::free(ptr); }
+};
+
+struct SlabPolicy {
+    static const char* Name() { return "slab"; }
+    static void* Allocate(size_t size) { return atl::SlabAllocator::Allocate(size); }
+    static void Free(void* ptr) { atl::SlabAllocator::Free(ptr); }
+};
+
+size_t MallocInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.arena + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// 一个线程分配, 另一个线程释放, 模拟任务在提交线程分配而在工作线程释放
+template<class Policy>
+void CrossThread(size_t size, int count, int rounds) {
+    std::vector<void*> blocks(count);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < count; i++) {
+            blocks[i] = Policy::Allocate(size);
+        }
+        std::thread thrd([&blocks]() {
+            for (void* ptr : blocks) {
+                Policy::Free(ptr);
+            }
+        });
+        thrd.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << Policy::Name() << " cross thread size: " << size
+              << " ops: " << static_cast<long long>(count) * rounds
+              << " elapsed: " << elapsed << "us"
+              << " ns/op: " << elapsed * 1000.0 / (static_cast<double>(count) * rounds) << std::endl;
+}
+
+// 同一线程分配并释放
+template<class Policy>
+void SameThread(size_t size, int count, int rounds) {
+    std::vector<void*> blocks(count);
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < count; i++) {
+            blocks[i] = Policy::Allocate(size);
+        }
+        for (int i = 0; i < count; i++) {
+            Policy::Free(blocks[i]);
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << Policy::Name() << " same thread  size: " << size
+              << " ops: " << static_cast<long long>(count) * rounds
+              << " elapsed: " << elapsed << "us"
+              << " ns/op: " << elapsed * 1000.0 / (static_cast<double>(count) * rounds) << std::endl;
+}
+
+// 用法: slab_allocator_example [count] [rounds]
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    for (size_t size : {48, 128, 320}) {
+        SameThread<MallocPolicy>(size, count, rounds);
+        SameThread<SlabPolicy>(size, count, rounds);
+        CrossThread<MallocPolicy>(size, count, rounds);
+        CrossThread<SlabPolicy>(size, count, rounds);
+    }
+
+    atl::SlabAllocator::Stats stats = atl::SlabAllocator::GetStats();
+    std::cout << "malloc heap: " << MallocInUse() << " bytes" << std::endl;
+    std::cout << "slab reserved: " << stats.reserved_bytes << " bytes"
+              << " used blocks: " << stats.used_blocks
+              << " used bytes: " << stats.used_bytes
+              << " remote frees: " << stats.remote_frees
+              << " thread caches: " << stats.thread_caches << std::endl;
+    return 0;
+}
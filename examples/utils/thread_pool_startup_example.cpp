@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+
+#include "atl/utils/thread_pool.h"
+
+struct Memory {
+    size_t virtual_bytes;
+    size_t resident_bytes;
+};
+
+Memory CurrentMemory() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    statm >> size >> resident;
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return Memory{size * page, resident * page};
+}
+
+// 创建pool_count个线程池, 每个线程池提交一个任务, 报告启动耗时, 第一个任务的冷启动延迟和内存占用
+void Run(const char* label, int pool_count, int pool_size, const atl::WorkerThreadOptions& options) {
+    Memory before = CurrentMemory();
+    std::vector<std::unique_ptr<atl::ThreadPool>> pools;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < pool_count; i++) {
+        pools.emplace_back(new atl::ThreadPool());
+        pools.back()->SetWorkerThreadOptions(options);
+        pools.back()->Start(pool_size);
+    }
+    auto started = std::chrono::steady_clock::now();
+    for (auto& pool : pools) {
+        pool->Push([]() { return 0; }).get();
+    }
+    auto finished = std::chrono::steady_clock::now();
+    Memory after = CurrentMemory();
+
+    int64_t start_ns = 0;
+    int64_t latency_ns = 0;
+    int threads = 0;
+    for (auto& pool : pools) {
+        atl::StartupStats stats = pool->GetStartupStats();
+        start_ns += stats.start_ns;
+        latency_ns += stats.first_task_latency_ns;
+        threads += stats.started_workers;
+    }
+    std::cout << label
+              << " start: " << std::chrono::duration_cast<std::chrono::microseconds>(started - start).count() << "us"
+              << " (" << start_ns / pool_count / 1000 << "us/pool)"
+              << " first task: " << std::chrono::duration_cast<std::chrono::microseconds>(finished - started).count()
+              << "us (" << latency_ns / pool_count / 1000 << "us/pool)"
+              << " threads: " << threads
+              << " virtual: " << (after.virtual_bytes - before.virtual_bytes) / 1024 << "KB"
+              << " resident: " << (after.resident_bytes - before.resident_bytes) / 1024 << "KB" << std::endl;
+
+    for (auto& pool : pools) {
+        pool->Stop();
+    }
+    for (auto& pool : pools) {
+        pool->Wait();
+    }
+}
+
+// 用法: thread_pool_startup_example [pool_count] [pool_size] [stack_kb]
+int main(int argc, char* argv[]) {
+    int pool_count = argc > 1 ? std::atoi(argv[1]) : 16;
+    int pool_size = argc > 2 ? std::atoi(argv[2]) : 8;
+    size_t stack_kb = argc > 3 ? static_cast<size_t>(std::atoi(argv[3])) : 256;
+
+    atl::WorkerThreadOptions eager;
+    Run("eager", pool_count, pool_size, eager);
+
+    atl::WorkerThreadOptions lazy;
+    lazy.lazy_start = true;
+    lazy.stack_size = stack_kb * 1024;
+    lazy.name = "atl-example";
+    Run("lazy ", pool_count, pool_size, lazy);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+#include "atl/utils/actor.h"
+#include "atl/utils/thread_pool2.h"
+
+// 多个线程同时发送, 同一个Actor的消息串行处理, 每个发送线程的消息保持顺序
+TEST(Actor, SerialAndOrdered) {
+    atl::ThreadPool2 pool;
+    pool.Start(4);
+    struct State {
+        std::vector<int> last;
+        int count = 0;
+        bool ordered = true;
+    };
+    const int sender_count = 4;
+    const int message_count = 10000;
+    std::promise<void> done;
+    State initial;
+    initial.last.assign(sender_count, -1);
+    atl::Actor<State, std::pair<int, int>> actor(pool, initial,
+        [&done](State& state, std::pair<int, int>& msg) {
+            if (state.last[msg.first] + 1 != msg.second) {
+                state.ordered = false;
+            }
+            state.last[msg.first] = msg.second;
+            if (++state.count == sender_count * message_count) {
+                EXPECT_TRUE(state.ordered);
+                done.set_value();
+            }
+        }, 16);
+
+    std::vector<std::thread> senders;
+    for (int s = 0; s < sender_count; s++) {
+        senders.emplace_back([&actor, s]() {
+            for (int i = 0; i < message_count; i++) {
+                actor.Send(std::make_pair(s, i));
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    done.get_future().get();
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(0u, actor.Pending());
+}
+
+TEST(Actor, ManyActors) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    const int actor_count = 1000;
+    const int message_count = 10;
+    std::atomic<int> total(0);
+    std::promise<void> done;
+    std::vector<std::unique_ptr<atl::Actor<int, int>>> actors;
+    for (int i = 0; i < actor_count; i++) {
+        actors.emplace_back(new atl::Actor<int, int>(pool, 0, [&total, &done](int& sum, int& value) {
+            sum += value;
+            if (total.fetch_add(1) + 1 == actor_count * message_count) {
+                done.set_value();
+            }
+        }));
+    }
+    for (int m = 0; m < message_count; m++) {
+        for (auto& actor : actors) {
+            actor->Send(1);
+        }
+    }
+    done.get_future().get();
+    pool.Stop();
+    pool.Wait();
+}
+
+// 消息在Actor销毁时仍未处理, 不会泄漏
+TEST(Actor, DestroyWithPending) {
+    atl::ThreadPool2 pool;
+    pool.Start(1);
+    pool.Stop();
+    pool.Wait();
+    auto msg = std::make_shared<int>(1);
+    {
+        atl::Actor<int, std::shared_ptr<int>> actor(pool, 0, [](int&, std::shared_ptr<int>&) {});
+        actor.Send(msg);
+        actor.Send(msg);
+        EXPECT_EQ(3, msg.use_count());
+    }
+    EXPECT_EQ(1, msg.use_count());
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "atl/utils/admission_controller.h"
+
+using Clock = atl::AdmissionController::Clock;
+
+// 排队时间持续一个interval高于target后进入过载状态, 出现低于target的排队时间后恢复
+TEST(AdmissionController, OverloadAndRecover) {
+    atl::AdmissionController controller(std::chrono::milliseconds(5), std::chrono::milliseconds(100));
+    Clock::time_point base = Clock::now();
+    auto at = [base](int ms) { return base + std::chrono::milliseconds(ms); };
+
+    EXPECT_FALSE(controller.OnDequeue(at(-10), at(0), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.OnDequeue(at(40), at(50), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.IsOverloaded());
+    EXPECT_TRUE(controller.Admit(atl::TaskPriority::kLow));
+
+    EXPECT_TRUE(controller.OnDequeue(at(91), at(101), atl::TaskPriority::kLow));
+    EXPECT_TRUE(controller.IsOverloaded());
+    EXPECT_FALSE(controller.OnDequeue(at(92), at(102), atl::TaskPriority::kNormal));
+    EXPECT_FALSE(controller.Admit(atl::TaskPriority::kLow));
+    EXPECT_TRUE(controller.Admit(atl::TaskPriority::kNormal));
+
+    EXPECT_FALSE(controller.OnDequeue(at(102), at(103), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.IsOverloaded());
+    EXPECT_TRUE(controller.Admit(atl::TaskPriority::kLow));
+
+    atl::AdmissionController::Stats stats = controller.GetStats();
+    EXPECT_EQ(1u, stats.rejected);
+    EXPECT_EQ(1u, stats.shed);
+    EXPECT_EQ(1u, stats.overloads);
+}
+
+// 一次低于target的排队时间会重新开始计时
+TEST(AdmissionController, ShortSpike) {
+    atl::AdmissionController controller(std::chrono::milliseconds(5), std::chrono::milliseconds(100));
+    Clock::time_point base = Clock::now();
+    auto at = [base](int ms) { return base + std::chrono::milliseconds(ms); };
+
+    EXPECT_FALSE(controller.OnDequeue(at(-10), at(0), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.OnDequeue(at(59), at(60), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.OnDequeue(at(100), at(120), atl::TaskPriority::kLow));
+    EXPECT_FALSE(controller.IsOverloaded());
+
+    EXPECT_TRUE(controller.OnDequeue(at(200), at(220), atl::TaskPriority::kLow));
+    controller.OnIdle();
+    EXPECT_FALSE(controller.IsOverloaded());
+}
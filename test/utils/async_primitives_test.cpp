@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include "atl/utils/async_primitives.h"
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(AsyncSemaphore, AcquireRelease) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::AsyncSemaphore semaphore(pool, 2);
+    std::atomic<int> count(0);
+
+    semaphore.Acquire([&count]() { count.fetch_add(1); });
+    semaphore.Acquire([&count]() { count.fetch_add(1); });
+    EXPECT_EQ(2, count.load());
+    EXPECT_FALSE(semaphore.TryAcquire());
+
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    semaphore.Acquire([&count, &done]() {
+        count.fetch_add(1);
+        done.set_value();
+    });
+    EXPECT_EQ(2, count.load());
+    semaphore.Release();
+    future.get();
+    EXPECT_EQ(3, count.load());
+    EXPECT_EQ(0u, semaphore.Available());
+
+    semaphore.Release(2);
+    EXPECT_EQ(2u, semaphore.Available());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 大量任务竞争同一把异步锁, 单个工作线程也不会死锁
+TEST(AsyncMutex, Contention) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::AsyncMutex mutex(pool);
+    int counter = 0;
+    const int task_count = 1000;
+    atl::Latch* latch = new atl::Latch(pool, task_count);
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    latch->Wait([&done]() { done.set_value(); });
+
+    for (int i = 0; i < task_count; i++) {
+        pool.Push([&mutex, &counter, latch]() {
+            mutex.Lock([&mutex, &counter, latch]() {
+                counter++;
+                mutex.Unlock();
+                latch->CountDown();
+            });
+        });
+    }
+    future.get();
+    EXPECT_EQ(task_count, counter);
+    EXPECT_TRUE(mutex.TryLock());
+    mutex.Unlock();
+    delete latch;
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Latch, Wait) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    atl::Latch latch(pool, 3);
+    std::atomic<int> count(0);
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+
+    latch.Wait([&count, &done]() {
+        EXPECT_EQ(3, count.load());
+        done.set_value();
+    });
+    EXPECT_FALSE(latch.TryWait());
+    for (int i = 0; i < 3; i++) {
+        pool.Push([&count, &latch]() {
+            count.fetch_add(1);
+            latch.CountDown();
+        });
+    }
+    future.get();
+    EXPECT_TRUE(latch.TryWait());
+
+    // 计数为0后等待者立即执行
+    bool immediate = false;
+    latch.Wait([&immediate]() { immediate = true; });
+    EXPECT_TRUE(immediate);
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Barrier, Phases) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::atomic<int> phases(0);
+    std::atomic<int> arrivals(0);
+    atl::Barrier barrier(pool, 3, [&phases]() { phases.fetch_add(1); });
+    atl::Latch latch(pool, 3);
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    latch.Wait([&done]() { done.set_value(); });
+
+    for (int i = 0; i < 3; i++) {
+        pool.Push([&]() {
+            arrivals.fetch_add(1);
+            barrier.ArriveAndWait([&]() {
+                EXPECT_EQ(1, phases.load());
+                EXPECT_EQ(3, arrivals.load());
+                barrier.ArriveAndWait([&]() {
+                    EXPECT_EQ(2, phases.load());
+                    latch.CountDown();
+                });
+            });
+        });
+    }
+    future.get();
+    EXPECT_EQ(2, phases.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Barrier, ArriveAndDrop) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::atomic<int> phases(0);
+    atl::Barrier barrier(pool, 2, [&phases]() { phases.fetch_add(1); });
+    barrier.ArriveAndDrop();
+    EXPECT_EQ(0, phases.load());
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    barrier.ArriveAndWait([&done]() { done.set_value(); });
+    future.get();
+    EXPECT_EQ(1, phases.load());
+
+    // 之后每一轮只需要一个参与者
+    std::promise<void> done2;
+    std::future<void> future2 = done2.get_future();
+    barrier.ArriveAndWait([&done2]() { done2.set_value(); });
+    future2.get();
+    EXPECT_EQ(2, phases.load());
+    pool.Stop();
+    pool.Wait();
+}
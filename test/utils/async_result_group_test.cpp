@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include "atl/utils/async_result_group.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(AsyncResultGroup, Results) {
+    std::promise<std::vector<int>> done;
+    std::future<std::vector<int>> future = done.get_future();
+    atl::AsyncResultGroup<int> group([&done](atl::ResultSpan<int> results) {
+        done.set_value(std::vector<int>(results.begin(), results.end()));
+    });
+    for (int i = 0; i < 10; i++) {
+        group.Push([i]() { return i * i; });
+    }
+    atl::ThreadPool pool;
+    pool.Start(4);
+    pool.Push(group.CreateAsyncGroup());
+
+    std::vector<int> results = future.get();
+    ASSERT_EQ(10u, results.size());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(i * i, results[i]);
+    }
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(AsyncResultGroup, SlotsAreCacheLineSeparated) {
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    atl::AsyncResultGroup<char> group([&done](atl::ResultSpan<char> results) {
+        EXPECT_EQ(2u, results.Size());
+        EXPECT_EQ(64, &results[1] - &results[0]);
+        done.set_value();
+    });
+    group.Push([]() { return 'a'; });
+    group.Push([]() { return 'b'; });
+    atl::ThreadPool pool;
+    pool.Start(2);
+    pool.Push(group.CreateAsyncGroup());
+    future.get();
+    pool.Stop();
+    pool.Wait();
+}
+
+// 归约结果在分组完成回调之前给出, 任务数量不是2的幂时也能正确归约
+TEST(AsyncResultGroup, Reduce) {
+    for (int count : {1, 2, 3, 7, 8, 100}) {
+        long long reduced = -1;
+        std::promise<long long> done;
+        std::future<long long> future = done.get_future();
+        atl::AsyncResultGroup<long long> group([&done, &reduced](atl::ResultSpan<long long> results) {
+            long long sum = 0;
+            for (long long value : results) {
+                sum += value;
+            }
+            EXPECT_EQ(sum, reduced);
+            done.set_value(reduced);
+        });
+        group.SetReducer([](const long long& lhs, const long long& rhs) { return lhs + rhs; },
+                         [&reduced](long long& value) { reduced = value; });
+        for (int i = 1; i <= count; i++) {
+            group.Push([i]() -> long long { return i; });
+        }
+        atl::ThreadPool2 pool;
+        pool.Start(3);
+        pool.Push(group.CreateAsyncGroup());
+        EXPECT_EQ(static_cast<long long>(count) * (count + 1) / 2, future.get());
+        pool.Stop();
+        pool.Wait();
+    }
+}
+
+// 归约函数不要求满足交换律, 但要求满足结合律
+TEST(AsyncResultGroup, ReduceKeepsOrder) {
+    std::promise<std::string> done;
+    std::future<std::string> future = done.get_future();
+    atl::AsyncResultGroup<std::string> group;
+    group.SetReducer([](const std::string& lhs, const std::string& rhs) { return lhs + rhs; },
+                     [&done](std::string& value) { done.set_value(value); });
+    for (char c = 'a'; c <= 'k'; c++) {
+        group.Push([c]() { return std::string(1, c); });
+    }
+    atl::ThreadPool pool;
+    pool.Start(4);
+    pool.Push(group.CreateAsyncGroup());
+    EXPECT_EQ("abcdefghijk", future.get());
+    pool.Stop();
+    pool.Wait();
+}
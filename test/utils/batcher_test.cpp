@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "atl/utils/batcher.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(Batcher, FlushBySize) {
+    std::mutex mtx;
+    std::vector<std::vector<int>> batches;
+    atl::ThreadPool pool;
+    pool.Start(2);
+    {
+        atl::Batcher<int> batcher(pool, 4, std::chrono::seconds(10), [&mtx, &batches](std::vector<int>&& batch) {
+            std::lock_guard<std::mutex> lock(mtx);
+            batches.push_back(std::move(batch));
+        });
+        for (int i = 0; i < 8; i++) {
+            batcher.Add(i);
+        }
+        while (batcher.GetStats().batches < 2) {
+            std::this_thread::yield();
+        }
+        atl::BatcherStats stats = batcher.GetStats();
+        EXPECT_EQ(8u, stats.items);
+        EXPECT_EQ(2u, stats.size_flushes);
+        EXPECT_EQ(2u, stats.histogram[2]);
+    }
+    for (;;) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (batches.size() == 2) {
+            break;
+        }
+    }
+    pool.Stop();
+    pool.Wait();
+    ASSERT_EQ(2u, batches.size());
+    EXPECT_EQ(4u, batches[0].size());
+    EXPECT_EQ(4u, batches[1].size());
+}
+
+TEST(Batcher, FlushByTimer) {
+    std::promise<std::vector<int>> done;
+    std::future<std::vector<int>> future = done.get_future();
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Batcher<int> batcher(pool, 256, std::chrono::milliseconds(5), [&done](std::vector<int>&& batch) {
+        done.set_value(std::move(batch));
+    });
+    batcher.Add(1);
+    batcher.Add(2);
+    batcher.Add(3);
+    EXPECT_EQ(std::vector<int>({1, 2, 3}), future.get());
+    atl::BatcherStats stats = batcher.GetStats();
+    EXPECT_EQ(1u, stats.timer_flushes);
+    EXPECT_EQ(1u, stats.histogram[1]);
+    pool.Stop();
+    pool.Wait();
+}
+
+// 每个生产者线程有独立的缓冲区, 析构时提交剩余元素
+TEST(Batcher, MultipleProducers) {
+    std::atomic<int> sum(0);
+    std::atomic<int> items(0);
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    {
+        atl::Batcher<int, atl::ThreadPool2> batcher(pool, 16, std::chrono::milliseconds(1),
+                                                    [&sum, &items](std::vector<int>&& batch) {
+            for (int value : batch) {
+                sum.fetch_add(value);
+            }
+            items.fetch_add(static_cast<int>(batch.size()));
+        });
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; p++) {
+            producers.emplace_back([&batcher]() {
+                for (int i = 1; i <= 100; i++) {
+                    batcher.Add(i);
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+    while (items.load() < 400) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(4 * 5050, sum.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 同一个生产者线程先后使用很多batcher, 已销毁的batcher在线程本地表中的登记被清理后不影响新的batcher
+TEST(Batcher, ManySequentialBatchers) {
+    std::atomic<int> total(0);
+    atl::ThreadPool pool;
+    pool.Start(2);
+    for (int round = 0; round < 200; round++) {
+        atl::Batcher<int> batcher(pool, 3, std::chrono::seconds(10), [&total](std::vector<int>&& batch) {
+            total.fetch_add(static_cast<int>(batch.size()));
+        });
+        batcher.Add(round);
+        batcher.Add(round);
+    }
+    while (total.load() < 400) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(400, total.load());
+    pool.Stop();
+    pool.Wait();
+}
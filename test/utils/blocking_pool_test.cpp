@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include "atl/utils/blocking_pool.h"
+
+// 阻塞的任务各自占用一个线程, 不会互相等待
+TEST(BlockingPool, Elastic) {
+    atl::BlockingPool pool(8, std::chrono::milliseconds(20));
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    std::atomic<int> started(0);
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 4; i++) {
+        futures.push_back(pool.Push([&started, gate_future]() {
+            started.fetch_add(1);
+            gate_future.wait();
+        }));
+    }
+    while (started.load() < 4) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(4u, pool.ThreadCount());
+    gate.set_value();
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    // 空闲线程被复用, 超过keep_alive后退出
+    EXPECT_EQ(3, pool.Push([]() { return 3; }).get());
+    EXPECT_LE(pool.ThreadCount(), 4u);
+    for (int i = 0; i < 200 && pool.ThreadCount() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(0u, pool.ThreadCount());
+    EXPECT_EQ(4, pool.Push([]() { return 4; }).get());
+}
+
+// 线程数达到上限后任务排队
+TEST(BlockingPool, MaxThreads) {
+    atl::BlockingPool pool(2);
+    std::atomic<int> running(0);
+    std::atomic<int> max_running(0);
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 8; i++) {
+        futures.push_back(pool.Push([&running, &max_running]() {
+            int current = running.fetch_add(1) + 1;
+            int expected = max_running.load();
+            while (current > expected && !max_running.compare_exchange_weak(expected, current)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            running.fetch_sub(1);
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_LE(max_running.load(), 2);
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(0u, pool.ThreadCount());
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include "atl/utils/cancellation.h"
+
+TEST(CancellationToken, Default) {
+    atl::CancellationToken token;
+    EXPECT_FALSE(token.CanBeCancelled());
+    EXPECT_FALSE(token.IsCancellationRequested());
+}
+
+TEST(CancellationSource, Cancel) {
+    atl::CancellationSource source;
+    atl::CancellationToken token1 = source.Token();
+    atl::CancellationToken token2 = source.Token();
+    EXPECT_TRUE(token1.CanBeCancelled());
+    EXPECT_FALSE(source.IsCancellationRequested());
+    EXPECT_FALSE(token1.IsCancellationRequested());
+    EXPECT_FALSE(token2.IsCancellationRequested());
+
+    source.Cancel();
+    EXPECT_TRUE(source.IsCancellationRequested());
+    EXPECT_TRUE(token1.IsCancellationRequested());
+    EXPECT_TRUE(token2.IsCancellationRequested());
+}
+
+TEST(CancellationSource, Copy) {
+    atl::CancellationSource source;
+    atl::CancellationSource copy = source;
+    atl::CancellationToken token = source.Token();
+
+    copy.Cancel();
+    EXPECT_TRUE(source.IsCancellationRequested());
+    EXPECT_TRUE(token.IsCancellationRequested());
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include "atl/utils/channel.h"
+#include "atl/utils/thread_pool.h"
+
+TEST(Channel, Buffered) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<int> channel(pool, 2);
+    int sent = 0;
+    channel.Send(1, [&sent](bool ok) { sent += ok; });
+    channel.Send(2, [&sent](bool ok) { sent += ok; });
+    EXPECT_EQ(2, sent);
+    EXPECT_EQ(2u, channel.Size());
+
+    int value = 3;
+    EXPECT_FALSE(channel.TrySend(value));
+    std::promise<void> third_sent;
+    channel.Send(3, [&third_sent](bool ok) { EXPECT_TRUE(ok); third_sent.set_value(); });
+
+    EXPECT_TRUE(channel.TryReceive(value));
+    EXPECT_EQ(1, value);
+    third_sent.get_future().get();
+    EXPECT_TRUE(channel.TryReceive(value));
+    EXPECT_EQ(2, value);
+    EXPECT_TRUE(channel.TryReceive(value));
+    EXPECT_EQ(3, value);
+    EXPECT_FALSE(channel.TryReceive(value));
+    pool.Stop();
+    pool.Wait();
+}
+
+// 无缓冲通道: 发送方在接收方取走数据后才完成
+TEST(Channel, Unbuffered) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<std::string> channel(pool, 0);
+    std::atomic<bool> sent(false);
+    std::promise<void> done;
+    channel.Send("hello", [&sent, &done](bool ok) {
+        sent = ok;
+        done.set_value();
+    });
+    EXPECT_FALSE(sent.load());
+
+    std::string received;
+    channel.Receive([&received](std::optional<std::string> value) { received = *value; });
+    EXPECT_EQ("hello", received);
+    done.get_future().get();
+    EXPECT_TRUE(sent.load());
+
+    std::promise<std::string> receiving;
+    channel.Receive([&receiving](std::optional<std::string> value) { receiving.set_value(*value); });
+    std::string value = "world";
+    EXPECT_TRUE(channel.TrySend(value));
+    EXPECT_EQ("world", receiving.get_future().get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 关闭后剩余数据仍可接收, 等待中的接收方收到nullopt, 发送失败
+TEST(Channel, Close) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<int> channel(pool, 1);
+    channel.Send(1);
+    std::promise<bool> blocked_sender;
+    channel.Send(2, [&blocked_sender](bool ok) { blocked_sender.set_value(ok); });
+    channel.Close();
+    EXPECT_FALSE(blocked_sender.get_future().get());
+
+    bool sent = true;
+    channel.Send(3, [&sent](bool ok) { sent = ok; });
+    EXPECT_FALSE(sent);
+
+    std::optional<int> value;
+    channel.Receive([&value](std::optional<int> v) { value = v; });
+    EXPECT_EQ(1, *value);
+    channel.Receive([&value](std::optional<int> v) { value = v; });
+    EXPECT_FALSE(value.has_value());
+
+    atl::Channel<int> empty(pool, 0);
+    std::promise<bool> waiting;
+    empty.Receive([&waiting](std::optional<int> v) { waiting.set_value(v.has_value()); });
+    empty.Close();
+    EXPECT_FALSE(waiting.get_future().get());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Channel, MoveOnly) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<std::unique_ptr<int>> channel(pool, 0);
+    std::promise<int> received;
+    channel.Receive([&received](std::optional<std::unique_ptr<int>> value) { received.set_value(**value); });
+    channel.Send(std::make_unique<int>(42));
+    EXPECT_EQ(42, received.get_future().get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 多生产者多消费者, 每个值恰好被接收一次
+TEST(Channel, MultiProducerMultiConsumer) {
+    atl::ThreadPool pool;
+    pool.Start(4);
+    atl::Channel<int> channel(pool, 4);
+    const int producer_count = 4;
+    const int value_count = 1000;
+    std::atomic<long> sum(0);
+    std::atomic<int> received(0);
+    std::promise<void> done;
+
+    std::function<void()> consume = [&]() {
+        channel.Receive([&](std::optional<int> value) {
+            if (!value) {
+                return;
+            }
+            sum.fetch_add(*value);
+            if (received.fetch_add(1) + 1 == producer_count * value_count) {
+                done.set_value();
+            }
+            consume();
+        });
+    };
+    for (int i = 0; i < 4; i++) {
+        consume();
+    }
+    for (int p = 0; p < producer_count; p++) {
+        pool.Push([&channel]() {
+            for (int i = 1; i <= value_count; i++) {
+                channel.Send(i);
+            }
+        });
+    }
+    done.get_future().get();
+    EXPECT_EQ(static_cast<long>(producer_count) * value_count * (value_count + 1) / 2, sum.load());
+    channel.Close();
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Select, FirstReady) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<int> numbers(pool, 1);
+    atl::Channel<std::string> names(pool, 1);
+    std::promise<std::string> selected;
+    atl::Select()
+        .OnReceive(numbers, [&selected](std::optional<int> value) { selected.set_value(std::to_string(*value)); })
+        .OnReceive(names, [&selected](std::optional<std::string> value) { selected.set_value(*value); })
+        .Run();
+    names.Send("name");
+    numbers.Send(1);
+    EXPECT_EQ("name", selected.get_future().get());
+
+    // 未被选中的分支不会取走数据
+    int value = 0;
+    EXPECT_TRUE(numbers.TryReceive(value));
+    EXPECT_EQ(1, value);
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Select, Default) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::Channel<int> channel(pool, 1);
+    int branch = 0;
+    atl::Select()
+        .OnReceive(channel, [&branch](std::optional<int>) { branch = 1; })
+        .OnDefault([&branch]() { branch = 2; })
+        .Run();
+    EXPECT_EQ(2, branch);
+
+    channel.Send(7);
+    int value = 0;
+    atl::Select()
+        .OnReceive(channel, [&branch, &value](std::optional<int> v) { branch = 1; value = *v; })
+        .OnDefault([&branch]() { branch = 2; })
+        .Run();
+    EXPECT_EQ(1, branch);
+    EXPECT_EQ(7, value);
+    pool.Stop();
+    pool.Wait();
+}
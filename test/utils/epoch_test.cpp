@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/epoch.h"
+#include "atl/utils/thread_pool.h"
+
+namespace {
+
+std::atomic<int> live_nodes(0);
+
+struct Node {
+    int value;
+    Node* next;
+    std::atomic<bool>* deleted;
+
+    explicit Node(int value, std::atomic<bool>* deleted = nullptr)
+        : value(value), next(nullptr), deleted(deleted) {
+        live_nodes++;
+    }
+    ~Node() {
+        if (deleted != nullptr) {
+            deleted->store(true);
+        }
+        live_nodes--;
+    }
+};
+
+// 在另一个线程上延迟释放并等待释放完成
+std::thread RetireAndFlush(Node* node) {
+    return std::thread([node]() {
+        atl::epoch::Retire(node);
+        atl::epoch::Flush();
+    });
+}
+
+}
+
+TEST(Epoch, GuardDefersReclamation) {
+    std::atomic<bool> deleted(false);
+    Node* node = new Node(1, &deleted);
+    std::promise<void> pinned;
+    std::promise<void> release;
+    std::thread reader([&]() {
+        atl::EpochGuard guard;
+        atl::EpochGuard nested;
+        pinned.set_value();
+        release.get_future().wait();
+        EXPECT_EQ(1, node->value);
+    });
+    pinned.get_future().wait();
+    std::thread reclaimer = RetireAndFlush(node);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(deleted.load());
+    release.set_value();
+    reader.join();
+    reclaimer.join();
+    EXPECT_TRUE(deleted.load());
+}
+
+TEST(Epoch, WorkerQuiescentBetweenTasks) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::atomic<bool> deleted(false);
+    Node* node = new Node(2, &deleted);
+    std::promise<void> running;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    // 任务内不需要EpochGuard, 空闲的工作线程处于离线状态, 不阻止回收
+    std::future<int> value = pool.Push([&running, released, node]() {
+        running.set_value();
+        released.wait();
+        return node->value;
+    });
+    running.get_future().wait();
+    std::thread reclaimer = RetireAndFlush(node);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(deleted.load());
+    release.set_value();
+    EXPECT_EQ(2, value.get());
+    reclaimer.join();
+    EXPECT_TRUE(deleted.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Epoch, TreiberStack) {
+    std::atomic<Node*> head(nullptr);
+    atl::epoch::Stats before = atl::epoch::GetStats();
+    atl::ThreadPool pool;
+    pool.Start(4);
+    const int kTasks = 8;
+    const int kCount = 5000;
+    std::atomic<long long> popped_sum(0);
+    std::vector<std::future<void>> futures;
+    for (int t = 0; t < kTasks; t++) {
+        futures.push_back(pool.Push([&head, &popped_sum, t, kCount]() {
+            for (int i = 0; i < kCount; i++) {
+                Node* node = new Node(t * kCount + i);
+                node->next = head.load();
+                while (!head.compare_exchange_weak(node->next, node)) {
+                }
+                Node* top = head.load();
+                while (top != nullptr && !head.compare_exchange_weak(top, top->next)) {
+                }
+                if (top != nullptr) {
+                    popped_sum += top->value;
+                    atl::epoch::Retire(top);
+                }
+            }
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    pool.Stop();
+    pool.Wait();
+
+    long long total = static_cast<long long>(kTasks) * kCount;
+    EXPECT_EQ(nullptr, head.load());
+    EXPECT_EQ(total * (total - 1) / 2, popped_sum.load());
+    // 工作线程退出时留下的对象由之后推进纪元的线程释放
+    atl::epoch::Retire(new Node(-1));
+    atl::epoch::Flush();
+    EXPECT_EQ(0, live_nodes.load());
+    atl::epoch::Stats after = atl::epoch::GetStats();
+    EXPECT_EQ(static_cast<uint64_t>(total + 1), after.retired - before.retired);
+    EXPECT_EQ(after.retired, after.reclaimed);
+    EXPECT_GT(after.epoch, before.epoch);
+}
+
+TEST(Epoch, RetireFromDeleter) {
+    struct Tree {
+        std::vector<Node*> children;
+        ~Tree() {
+            for (Node* child : children) {
+                atl::epoch::Retire(child);
+            }
+        }
+    };
+    int before = live_nodes.load();
+    std::thread reclaimer([]() {
+        // 超过一批的父节点, 释放时在deleter中继续延迟释放子节点
+        for (int i = 0; i < 200; i++) {
+            Tree* tree = new Tree();
+            for (int j = 0; j < 4; j++) {
+                tree->children.push_back(new Node(j));
+            }
+            atl::epoch::Retire(tree);
+        }
+        atl::epoch::Flush();
+    });
+    reclaimer.join();
+    EXPECT_EQ(before, live_nodes.load());
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "atl/utils/execution.h"
+
+namespace ex = atl::execution;
+
+TEST(Execution, ScheduleThen) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    ex::Scheduler scheduler(pool);
+    auto sender = ex::schedule(scheduler)
+                | ex::then([&pool]() { return pool.WorkerIndex(); })
+                | ex::then([](int index) { return std::to_string(index >= 0); });
+    std::optional<std::tuple<std::string>> result = ex::sync_wait(std::move(sender));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ("1", std::get<0>(*result));
+
+    std::optional<std::tuple<>> empty = ex::sync_wait(ex::schedule(scheduler) | ex::then([]() {}));
+    EXPECT_TRUE(empty.has_value());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Execution, WhenAll) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::ThreadPool2 pool2;
+    pool2.Start(2);
+    ex::Scheduler scheduler(pool);
+    ex::Scheduler scheduler2(pool2);
+    auto sender = ex::when_all(ex::schedule(scheduler) | ex::then([]() { return 1; }),
+                               ex::schedule(scheduler2) | ex::then([]() {}),
+                               ex::just(std::string("two"), 3.0),
+                               ex::when_all(ex::schedule(scheduler2) | ex::then([]() { return 4; })))
+                | ex::then([](int one, std::string two, double three, int four) {
+                      return one + static_cast<int>(two.size()) + static_cast<int>(three) + four;
+                  });
+    std::optional<std::tuple<int>> result = ex::sync_wait(std::move(sender));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(11, std::get<0>(*result));
+    pool2.Stop();
+    pool2.Wait();
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Execution, Bulk) {
+    atl::ThreadPool pool;
+    pool.Start(4);
+    ex::Scheduler scheduler(pool);
+    std::vector<std::atomic<int>> hits(1000);
+    std::atomic<int> workers_mask(0);
+    auto sender = ex::schedule(scheduler)
+                | ex::then([]() { return 7; })
+                | ex::bulk(1000, [&hits, &pool, &workers_mask](int i, int& value) {
+                      hits[i].fetch_add(value);
+                      workers_mask.fetch_or(1 << pool.WorkerIndex());
+                  })
+                | ex::then([](int value) { return value * 2; });
+    std::optional<std::tuple<int>> result = ex::sync_wait(std::move(sender));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(14, std::get<0>(*result));
+    for (auto& hit : hits) {
+        EXPECT_EQ(7, hit.load());
+    }
+    EXPECT_NE(0, workers_mask.load());
+
+    // 不在线程池上完成的上游在当前线程上依次执行
+    int sum = 0;
+    ex::sync_wait(ex::bulk(ex::just(), 10, [&sum](int i) { sum += i; }));
+    EXPECT_EQ(45, sum);
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Execution, ErrorAndStopped) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    ex::Scheduler scheduler(pool);
+    auto failing = ex::schedule(scheduler)
+                 | ex::then([]() -> int { throw std::runtime_error("failed"); })
+                 | ex::then([](int value) { return value + 1; });
+    EXPECT_THROW(ex::sync_wait(std::move(failing)), std::runtime_error);
+
+    auto bulk_failing = ex::schedule(scheduler) | ex::bulk(100, [](int i) {
+        if (i == 50) {
+            throw std::logic_error("bulk");
+        }
+    });
+    EXPECT_THROW(ex::sync_wait(std::move(bulk_failing)), std::logic_error);
+
+    auto all_failing = ex::when_all(ex::schedule(scheduler),
+                                    ex::just() | ex::then([]() { throw std::runtime_error("when_all"); }));
+    EXPECT_THROW(ex::sync_wait(std::move(all_failing)), std::runtime_error);
+
+    // 线程池停止后提交的任务节点被丢弃, 下游收到set_stopped
+    pool.Stop();
+    pool.Wait();
+    EXPECT_FALSE(ex::sync_wait(ex::schedule(scheduler) | ex::then([]() { return 1; })).has_value());
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "atl/utils/fiber.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(Fiber, SpawnAndYield) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    atl::FiberScheduler scheduler(pool);
+    std::atomic<int> steps(0);
+    std::atomic<bool> in_fiber(true);
+    for (int i = 0; i < 100; i++) {
+        scheduler.Spawn([&steps, &in_fiber]() {
+            for (int j = 0; j < 10; j++) {
+                in_fiber = in_fiber && atl::this_fiber::InFiber();
+                steps.fetch_add(1);
+                atl::this_fiber::Yield();
+            }
+        });
+    }
+    scheduler.Join();
+    EXPECT_EQ(1000, steps.load());
+    EXPECT_TRUE(in_fiber.load());
+    EXPECT_FALSE(atl::this_fiber::InFiber());
+    atl::FiberScheduler::Stats stats = scheduler.GetStats();
+    EXPECT_EQ(100u, stats.spawned);
+    EXPECT_EQ(100u, stats.finished);
+    EXPECT_EQ(1100u, stats.switches);
+    EXPECT_EQ(0u, scheduler.LiveCount());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 让出后排在已经就绪的纤程之后, 单线程时两个纤程交替执行
+TEST(Fiber, YieldIsFair) {
+    atl::ThreadPool2 pool;
+    pool.Start(1);
+    atl::FiberScheduler scheduler(pool);
+    std::string order;
+    for (char name : {'a', 'b'}) {
+        scheduler.Spawn([&order, name]() {
+            for (int i = 0; i < 4; i++) {
+                order.push_back(name);
+                atl::this_fiber::Yield();
+            }
+        });
+    }
+    scheduler.Join();
+    EXPECT_EQ("abababab", order);
+    pool.Stop();
+    pool.Wait();
+}
+
+// 持有锁时让出, 其他纤程挂起等待而不阻塞工作线程
+TEST(Fiber, Mutex) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    atl::FiberScheduler scheduler(pool);
+    atl::FiberMutex mutex;
+    int counter = 0;
+    for (int i = 0; i < 50; i++) {
+        scheduler.Spawn([&mutex, &counter]() {
+            for (int j = 0; j < 20; j++) {
+                std::lock_guard<atl::FiberMutex> lock(mutex);
+                int value = counter;
+                atl::this_fiber::Yield();
+                counter = value + 1;
+            }
+        });
+    }
+    scheduler.Join();
+    EXPECT_EQ(1000, counter);
+    EXPECT_TRUE(mutex.TryLock());
+    mutex.Unlock();
+    pool.Stop();
+    pool.Wait();
+}
+
+// 单个工作线程上, 一个纤程休眠时其他纤程继续执行
+TEST(Fiber, SleepFor) {
+    atl::ThreadPool2 pool;
+    pool.Start(1);
+    atl::FiberScheduler scheduler(pool);
+    std::atomic<bool> other_ran(false);
+    std::atomic<bool> ran_before_wake(false);
+    auto start = std::chrono::steady_clock::now();
+    scheduler.Spawn([&other_ran, &ran_before_wake]() {
+        atl::this_fiber::SleepFor(std::chrono::milliseconds(20));
+        ran_before_wake = other_ran.load();
+    });
+    scheduler.Spawn([&other_ran]() { other_ran = true; });
+    scheduler.Join();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    EXPECT_TRUE(ran_before_wake.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+int Depth(int n) {
+    volatile char buffer[256];
+    buffer[0] = static_cast<char>(n);
+    return n == 0 ? buffer[0] : Depth(n - 1) + 1;
+}
+
+// 栈在纤程结束后复用, 复用的栈可以正常递归
+TEST(Fiber, StackReuse) {
+    atl::ThreadPool2 pool;
+    pool.Start(1);
+    atl::FiberOptions options;
+    options.stack_size = 128 * 1024;
+    atl::FiberScheduler scheduler(pool, options);
+    std::atomic<int> result(0);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 16; i++) {
+            scheduler.Spawn([&result]() { result.fetch_add(Depth(100)); });
+        }
+        scheduler.Join();
+    }
+    EXPECT_EQ(48 * 100, result.load());
+    size_t reserved = scheduler.GetStats().stack_reserved_bytes;
+    EXPECT_GT(reserved, 0u);
+    EXPECT_LE(reserved, 16u * (128 * 1024 + 64 * 1024));
+    pool.Stop();
+    pool.Wait();
+}
+
+// 默认不放置保护页, 同时存在的纤程数超过vm.max_map_count的一半也能创建
+TEST(Fiber, ManyFibers) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    atl::FiberOptions options;
+    options.stack_size = 16 * 1024;
+    atl::FiberScheduler scheduler(pool, options);
+    const int fiber_count = 34000;
+    std::atomic<int> arrived(0);
+    for (int i = 0; i < fiber_count; i++) {
+        scheduler.Spawn([&arrived, fiber_count]() {
+            arrived.fetch_add(1);
+            while (arrived.load() < fiber_count) {
+                atl::this_fiber::Yield();
+            }
+        });
+    }
+    scheduler.Join();
+    EXPECT_EQ(static_cast<uint64_t>(fiber_count), scheduler.GetStats().finished);
+    pool.Stop();
+    pool.Wait();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include "atl/utils/fork_join.h"
+
+namespace {
+
+int SerialFib(int n) {
+    return n < 2 ? n : SerialFib(n - 1) + SerialFib(n - 2);
+}
+
+int ParallelFib(atl::ThreadPool& pool, int n) {
+    if (n < 2) {
+        return n;
+    }
+    int x = 0;
+    int y = 0;
+    atl::ForkJoinGroup group(pool);
+    group.Spawn([&pool, &x, n]() { x = ParallelFib(pool, n - 1); });
+    y = ParallelFib(pool, n - 2);
+    group.Sync();
+    return x + y;
+}
+
+}
+
+TEST(ForkJoinGroup, Fib) {
+    atl::ThreadPool pool;
+    pool.Start(4);
+    std::future<int> future = pool.Push([&pool]() -> int { return ParallelFib(pool, 18); });
+    EXPECT_EQ(SerialFib(18), future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 单个工作线程时, 等待子任务的线程自己执行子任务, 不会死锁
+TEST(ForkJoinGroup, SingleWorker) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::future<int> future = pool.Push([&pool]() -> int { return ParallelFib(pool, 15); });
+    EXPECT_EQ(SerialFib(15), future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 非工作线程调用Sync
+TEST(ForkJoinGroup, SyncFromOutside) {
+    std::atomic<int> count(0);
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::ForkJoinGroup group(pool);
+    for (int i = 0; i < 100; i++) {
+        group.Spawn([&count]() { count.fetch_add(1); });
+    }
+    group.Sync();
+    EXPECT_EQ(100, count.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ForkJoinGroup, Exception) {
+    std::atomic<int> count(0);
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::ForkJoinGroup group(pool);
+    group.Spawn([&count]() { count.fetch_add(1); });
+    group.Spawn([]() { throw std::runtime_error("spawn"); });
+    group.Spawn([&count]() { count.fetch_add(1); });
+    EXPECT_THROW(group.Sync(), std::runtime_error);
+    EXPECT_EQ(2, count.load());
+
+    group.Spawn([&count]() { count.fetch_add(1); });
+    EXPECT_NO_THROW(group.Sync());
+    EXPECT_EQ(3, count.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ForkJoinGroup, StopWithQueuedChildren) {
+    std::atomic<int> count(0);
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    std::promise<void> running;
+    std::future<void> blocker = pool.Push([&running, gate_future]() {
+        running.set_value();
+        gate_future.wait();
+    });
+    running.get_future().wait();
+    {
+        atl::ForkJoinGroup group(pool);
+        for (int i = 0; i < 10; i++) {
+            group.Spawn([&count]() { count.fetch_add(1); });
+        }
+        // 排队的子任务被丢弃, Sync和析构函数不会一直等待
+        pool.Stop();
+        group.Sync();
+        group.Spawn([&count]() { count.fetch_add(1); });
+    }
+    EXPECT_EQ(0, count.load());
+    gate.set_value();
+    blocker.get();
+    pool.Wait();
+}
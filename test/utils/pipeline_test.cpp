@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/pipeline.h"
+
+TEST(Pipeline, OrderThroughParallelStage) {
+    struct Item {
+        int id = 0;
+        std::string text;
+    };
+    std::vector<int> output;
+    atl::Pipeline<Item> pipeline(8);
+    pipeline.AddSerialStage("parse", [](Item& item) { item.text = std::to_string(item.id); })
+            .AddParallelStage("transform", 4, [](Item& item) {
+                // 让后面的元素先完成
+                std::this_thread::sleep_for(std::chrono::microseconds((item.id % 7) * 50));
+                item.text += "!";
+            })
+            .AddSerialStage("write", [&output](Item& item) {
+                EXPECT_EQ(std::to_string(item.id) + "!", item.text);
+                output.push_back(item.id);
+            });
+    pipeline.Start();
+    for (int i = 0; i < 1000; i++) {
+        Item item;
+        item.id = i;
+        pipeline.Push(std::move(item));
+    }
+    pipeline.Close();
+
+    ASSERT_EQ(1000u, output.size());
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(i, output[i]);
+    }
+    std::vector<atl::PipelineStageStats> stats = pipeline.GetStats();
+    ASSERT_EQ(3u, stats.size());
+    EXPECT_EQ("transform", stats[1].name);
+    EXPECT_EQ(4, stats[1].concurrency);
+    for (auto& stage : stats) {
+        EXPECT_EQ(1000u, stage.processed);
+        EXPECT_GT(stage.throughput, 0.0);
+    }
+}
+
+TEST(Pipeline, Backpressure) {
+    std::atomic<int> pushed(0);
+    std::atomic<int> written(0);
+    std::atomic<bool> release(false);
+    atl::Pipeline<int> pipeline(4);
+    pipeline.AddParallelStage("transform", 2, [](int& value) { value *= 2; })
+            .AddSerialStage("write", [&](int&) {
+                while (!release.load()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                written++;
+            });
+    pipeline.Start();
+    std::thread producer([&]() {
+        for (int i = 0; i < 100; i++) {
+            pipeline.Push(int(i));
+            pushed++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // 两个容量为4的队列, 加上写入阶段和并行阶段手里的元素, Push最终会被阻塞
+    EXPECT_LE(pushed.load(), 4 + 4 + 1 + 2);
+    EXPECT_EQ(0, written.load());
+    release = true;
+    producer.join();
+    pipeline.Close();
+    EXPECT_EQ(100, written.load());
+    std::vector<atl::PipelineStageStats> stats = pipeline.GetStats();
+    EXPECT_GT(stats[0].output_wait_ns, 0u);
+    EXPECT_GT(stats[1].busy_ns, 0u);
+}
+
+TEST(Pipeline, Empty) {
+    int count = 0;
+    atl::Pipeline<int> pipeline;
+    pipeline.AddSerialStage("count", [&count](int&) { count++; });
+    pipeline.Start();
+    pipeline.Close();
+    EXPECT_EQ(0, count);
+    EXPECT_EQ(0u, pipeline.GetStats()[0].processed);
+}
+
+TEST(Pipeline, Misuse) {
+    atl::Pipeline<int> empty;
+    EXPECT_THROW(empty.Start(), std::logic_error);
+    EXPECT_THROW(empty.Push(1), std::logic_error);
+
+    atl::Pipeline<int> pipeline;
+    pipeline.AddSerialStage("noop", [](int&) {});
+    EXPECT_THROW(pipeline.Push(1), std::logic_error);
+    pipeline.Start();
+    EXPECT_THROW(pipeline.AddSerialStage("late", [](int&) {}), std::logic_error);
+    pipeline.Push(1);
+    pipeline.Close();
+    EXPECT_THROW(pipeline.Push(2), std::logic_error);
+    EXPECT_EQ(1u, pipeline.GetStats()[0].processed);
+}
+
+TEST(Pipeline, PushRacingClose) {
+    for (int round = 0; round < 20; round++) {
+        std::atomic<int> processed(0);
+        atl::Pipeline<int> pipeline(4);
+        pipeline.AddSerialStage("count", [&processed](int&) { processed++; });
+        pipeline.Start();
+        std::atomic<int> pushed(0);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; i++) {
+            threads.emplace_back([&pipeline, &pushed]() {
+                try {
+                    while (true) {
+                        pipeline.Push(1);
+                        pushed++;
+                    }
+                } catch (const std::logic_error&) {
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200 * (round % 5)));
+        pipeline.Close();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(pushed.load(), processed.load());
+        EXPECT_EQ(static_cast<uint64_t>(pushed.load()), pipeline.GetStats()[0].processed);
+    }
+}
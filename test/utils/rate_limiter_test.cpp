@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "atl/utils/rate_limiter.h"
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(TokenBucket, Burst) {
+    atl::TokenBucket bucket(1, 3);
+    EXPECT_TRUE(bucket.TryAcquire());
+    EXPECT_TRUE(bucket.TryAcquire());
+    EXPECT_TRUE(bucket.TryAcquire());
+
+    atl::TokenBucket::Clock::duration wait;
+    EXPECT_FALSE(bucket.TryAcquire(&wait));
+    EXPECT_GT(wait, std::chrono::milliseconds(900));
+    EXPECT_LE(wait, std::chrono::seconds(1));
+}
+
+TEST(TokenBucket, Refill) {
+    atl::TokenBucket bucket(1000, 1);
+    EXPECT_TRUE(bucket.TryAcquire());
+    EXPECT_FALSE(bucket.TryAcquire());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_TRUE(bucket.TryAcquire());
+}
+
+// 超过突发数量的任务暂存在限速执行器中, 按速率提交到线程池
+TEST(RateLimitedExecutor, ThreadPool) {
+    std::atomic<int> count(0);
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::RateLimitedExecutor limiter(pool, 200, 5);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 15; i++) {
+        futures.push_back(limiter.Push([&count, i]() { count.fetch_add(1); return i; }));
+    }
+    EXPECT_GT(limiter.PendingCount(), 0u);
+    for (int i = 0; i < 15; i++) {
+        EXPECT_EQ(i, futures[i].get());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    // 5个突发之后还有10个任务, 每5ms一个令牌
+    EXPECT_GE(elapsed, std::chrono::milliseconds(45));
+    EXPECT_EQ(15, count.load());
+    EXPECT_EQ(0u, limiter.PendingCount());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(RateLimitedExecutor, ThreadPool2) {
+    std::atomic<int> count(0);
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    atl::RateLimitedExecutor limiter(pool, 1000, 1);
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    for (int i = 0; i < 10; i++) {
+        limiter.Execute([&count, &done]() {
+            if (count.fetch_add(1) + 1 == 10) {
+                done.set_value();
+            }
+        });
+    }
+    future.get();
+    EXPECT_EQ(10, count.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 限速执行器本身也是执行器, 可以叠加
+TEST(RateLimitedExecutor, Nested) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::RateLimitedExecutor outer(pool, 1000, 10);
+    atl::RateLimitedExecutor inner(outer, 1000, 10);
+    EXPECT_EQ(3, inner.Push([]() { return 3; }).get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 在调用线程上直接执行任务. TimerQueue线程第一次提交时停在gate上, 模拟暂存任务交给下层执行器的过程
+class GatedInlineExecutor : public atl::Executor {
+public:
+    void Execute(std::function<void()>&& task) override {
+        if (std::this_thread::get_id() != submit_thread_ && !gated_.exchange(true)) {
+            entered.set_value();
+            gate.get_future().wait();
+        }
+        std::lock_guard<std::mutex> lock(mtx_);
+        task();
+    }
+
+    std::promise<void> entered;
+    std::promise<void> gate;
+
+private:
+    std::thread::id submit_thread_ = std::this_thread::get_id();
+    std::atomic<bool> gated_{false};
+    std::mutex mtx_;
+};
+
+// 暂存的任务交给下层执行器之前, 新提交的任务不能走无锁路径插队
+TEST(RateLimitedExecutor, KeepsOrder) {
+    GatedInlineExecutor executor;
+    atl::RateLimitedExecutor limiter(executor, 1000, 1);
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+    auto record = [&mtx, &order, &done](int value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        order.push_back(value);
+        if (order.size() == 3) {
+            done.set_value();
+        }
+    };
+    limiter.Execute([&record]() { record(0); });
+    limiter.Execute([&record]() { record(1); });
+    // 任务1已经出队, 正在交给下层执行器; 等到令牌再次可用
+    executor.entered.get_future().wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    limiter.Execute([&record]() { record(2); });
+    executor.gate.set_value();
+    done.get_future().wait();
+    EXPECT_EQ(std::vector<int>({0, 1, 2}), order);
+}
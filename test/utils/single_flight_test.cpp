@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "atl/utils/single_flight.h"
+#include "atl/utils/thread_pool.h"
+
+// 计算执行期间相同key的请求合并为一次计算
+TEST(SingleFlight, JoinInFlight) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::SingleFlight<std::string, int> flight(pool);
+    std::atomic<int> executions(0);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    std::vector<std::shared_future<int>> futures;
+    for (int i = 0; i < 10; i++) {
+        futures.push_back(flight.PushOnce("key", [&executions, released]() {
+            executions.fetch_add(1);
+            released.wait();
+            return 42;
+        }));
+    }
+    std::shared_future<int> other = flight.PushOnce("other", []() { return 7; });
+    release.set_value();
+    for (auto& future : futures) {
+        EXPECT_EQ(42, future.get());
+    }
+    EXPECT_EQ(7, other.get());
+    EXPECT_EQ(1, executions.load());
+    EXPECT_EQ(9u, flight.GetStats().joined);
+
+    // 没有缓存时, 计算完成后再次请求会重新计算
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(0u, flight.Size());
+}
+
+TEST(SingleFlight, Ttl) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::SingleFlight<int, int> flight(pool, std::chrono::milliseconds(100));
+    std::atomic<int> executions(0);
+    auto compute = [&executions]() { return executions.fetch_add(1) + 1; };
+
+    EXPECT_EQ(1, flight.PushOnce(1, compute).get());
+    EXPECT_EQ(1, flight.PushOnce(1, compute).get());
+    EXPECT_EQ(1u, flight.GetStats().cache_hits);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_EQ(2, flight.PushOnce(1, compute).get());
+    flight.Erase(1);
+    EXPECT_EQ(3, flight.PushOnce(1, compute).get());
+    EXPECT_EQ(3u, flight.GetStats().executions);
+    pool.Stop();
+    pool.Wait();
+}
+
+// 异常传给所有等待者, 且不会被缓存
+TEST(SingleFlight, Exception) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::SingleFlight<int, int> flight(pool, std::chrono::seconds(60));
+    std::shared_future<int> failed = flight.PushOnce(1, []() -> int { throw std::runtime_error("failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_EQ(5, flight.PushOnce(1, []() { return 5; }).get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 大量不同的key过期后在插入时被清理, 索引不会无限增长
+TEST(SingleFlight, SweepExpired) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::SingleFlight<int, int> flight(pool, std::chrono::milliseconds(20));
+    for (int i = 0; i < 100; i++) {
+        flight.PushOnce(i * static_cast<int>(atl::SingleFlight<int, int>::kShardCount), [i]() { return i; }).get();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // 所有key都在同一个分片中
+    flight.PushOnce(-static_cast<int>(atl::SingleFlight<int, int>::kShardCount), []() { return 0; }).get();
+    EXPECT_EQ(1u, flight.Size());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 线程池停止时丢弃的计算不会永久占用key
+TEST(SingleFlight, DiscardedTask) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::promise<void> running;
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    std::future<void> blocker = pool.Push([&running, gate_future]() {
+        running.set_value();
+        gate_future.wait();
+    });
+    running.get_future().wait();
+
+    atl::SingleFlight<int, int> flight(pool, std::chrono::seconds(60));
+    std::shared_future<int> dropped = flight.PushOnce(1, []() { return 1; });
+    EXPECT_EQ(1u, flight.Size());
+    pool.Stop();
+    EXPECT_THROW(dropped.get(), std::future_error);
+    EXPECT_EQ(0u, flight.Size());
+    gate.set_value();
+    blocker.get();
+    pool.Wait();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "atl/utils/slab_allocator.h"
+
+TEST(SlabAllocator, AllocateFree) {
+    atl::SlabAllocator::Stats before = atl::SlabAllocator::GetStats();
+    void* ptr1 = atl::SlabAllocator::Allocate(40);
+    void* ptr2 = atl::SlabAllocator::Allocate(40);
+    EXPECT_NE(ptr1, ptr2);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr1) % 16);
+    std::memset(ptr1, 1, 40);
+    std::memset(ptr2, 2, 40);
+
+    atl::SlabAllocator::Stats during = atl::SlabAllocator::GetStats();
+    EXPECT_EQ(before.used_blocks + 2, during.used_blocks);
+    EXPECT_GE(during.reserved_bytes, during.used_bytes);
+
+    // 本线程释放的块会被本线程优先复用
+    atl::SlabAllocator::Free(ptr2);
+    void* ptr3 = atl::SlabAllocator::Allocate(33);
+    EXPECT_EQ(ptr2, ptr3);
+    atl::SlabAllocator::Free(ptr1);
+    atl::SlabAllocator::Free(ptr3);
+    atl::SlabAllocator::Free(nullptr);
+
+    atl::SlabAllocator::Stats after = atl::SlabAllocator::GetStats();
+    EXPECT_EQ(before.used_blocks, after.used_blocks);
+}
+
+TEST(SlabAllocator, Large) {
+    atl::SlabAllocator::Stats before = atl::SlabAllocator::GetStats();
+    void* ptr = atl::SlabAllocator::Allocate(atl::SlabAllocator::kMaxSlabSize + 1);
+    std::memset(ptr, 0, atl::SlabAllocator::kMaxSlabSize + 1);
+    atl::SlabAllocator::Free(ptr);
+    atl::SlabAllocator::Stats after = atl::SlabAllocator::GetStats();
+    EXPECT_EQ(before.large_allocations + 1, after.large_allocations);
+    EXPECT_EQ(before.used_blocks, after.used_blocks);
+}
+
+// 其他线程释放的块通过无锁链表还给分配线程, 分配线程再次分配时复用
+TEST(SlabAllocator, RemoteFree) {
+    const int count = 1000;
+    std::vector<void*> blocks;
+    atl::SlabAllocator::Stats before = atl::SlabAllocator::GetStats();
+    for (int i = 0; i < count; i++) {
+        blocks.push_back(atl::SlabAllocator::Allocate(100));
+    }
+    std::thread thrd([&blocks]() {
+        for (void* ptr : blocks) {
+            atl::SlabAllocator::Free(ptr);
+        }
+    });
+    thrd.join();
+
+    atl::SlabAllocator::Stats middle = atl::SlabAllocator::GetStats();
+    EXPECT_EQ(before.remote_frees + count, middle.remote_frees);
+    EXPECT_EQ(before.used_blocks, middle.used_blocks);
+
+    std::vector<void*> again;
+    for (int i = 0; i < count; i++) {
+        again.push_back(atl::SlabAllocator::Allocate(100));
+    }
+    atl::SlabAllocator::Stats after = atl::SlabAllocator::GetStats();
+    EXPECT_EQ(middle.reserved_bytes, after.reserved_bytes);
+    for (void* ptr : again) {
+        atl::SlabAllocator::Free(ptr);
+    }
+}
+
+struct SlabTestObject : public atl::SlabObject {
+    int values[8];
+};
+
+TEST(SlabObject, NewDelete) {
+    atl::SlabAllocator::Stats before = atl::SlabAllocator::GetStats();
+    SlabTestObject* obj = new SlabTestObject();
+    obj->values[7] = 7;
+    EXPECT_EQ(before.used_blocks + 1, atl::SlabAllocator::GetStats().used_blocks);
+    delete obj;
+    EXPECT_EQ(before.used_blocks, atl::SlabAllocator::GetStats().used_blocks);
+}
+
+namespace {
+
+struct alignas(64) OverAlignedObject : public atl::SlabObject {
+    char values[40];
+};
+
+}
+
+TEST(SlabObject, OverAligned) {
+    atl::SlabAllocator::Stats before = atl::SlabAllocator::GetStats();
+    std::vector<OverAlignedObject*> objects;
+    for (int i = 0; i < 16; i++) {
+        objects.push_back(new OverAlignedObject());
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(objects.back()) % 64);
+    }
+    // 对齐要求超过slab块的对象不使用slab
+    EXPECT_EQ(before.used_blocks, atl::SlabAllocator::GetStats().used_blocks);
+    for (OverAlignedObject* obj : objects) {
+        delete obj;
+    }
+}
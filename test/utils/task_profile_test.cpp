@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/thread_pool2.h"
+
+namespace {
+
+void Spin(std::chrono::milliseconds duration) {
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+}
+
+TEST(TaskProfile, ThreadPool) {
+    static const atl::TaskTag kSpinTag("profile.test.spin");
+    static const atl::TaskTag kSleepTag("profile.test.sleep");
+    atl::ThreadPool pool;
+    pool.EnableProfiling();
+    pool.Start(2);
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 4; i++) {
+        futures.push_back(pool.Push(kSpinTag, []() { Spin(std::chrono::milliseconds(10)); }));
+        futures.push_back(pool.Push(kSleepTag, []() { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }));
+    }
+    futures.push_back(pool.Push([]() {}));
+    for (auto& future : futures) {
+        future.get();
+    }
+    pool.Stop();
+    pool.Wait();
+
+    std::vector<atl::TagProfile> profiles = pool.GetProfile();
+    ASSERT_EQ(3u, profiles.size());
+    EXPECT_EQ(kSpinTag, profiles[0].tag);
+    EXPECT_EQ(4u, profiles[0].count);
+    EXPECT_GE(profiles[0].wall_ns, 40000000u);
+    EXPECT_GE(profiles[0].cpu_ns, profiles[0].wall_ns / 4);
+    EXPECT_EQ(kSleepTag, profiles[1].tag);
+    EXPECT_GE(profiles[1].wall_ns, 20000000u);
+    EXPECT_LT(profiles[1].cpu_ns, profiles[1].wall_ns / 2);
+    EXPECT_EQ(0u, profiles[2].tag.Id());
+    EXPECT_EQ(1u, profiles[2].count);
+
+    std::vector<atl::TagProfile> top = pool.GetProfile(1);
+    ASSERT_EQ(1u, top.size());
+    std::string text = atl::FormatProfileText(top);
+    EXPECT_NE(std::string::npos, text.find("profile.test.spin"));
+    EXPECT_EQ(std::string::npos, text.find("profile.test.sleep"));
+    EXPECT_NE(std::string::npos, atl::FormatProfileText(profiles).find("(untagged)"));
+    std::string json = atl::FormatProfileJson(top);
+    EXPECT_EQ(0u, json.find("[{\"tag\":\"profile.test.spin\",\"count\":4,\"wait_ns\":"));
+
+    pool.ResetProfile();
+    EXPECT_TRUE(pool.GetProfile().empty());
+}
+
+TEST(TaskProfile, ThreadPool2) {
+    atl::ThreadPool2 pool;
+    pool.EnableProfiling();
+    pool.Start(3);
+    atl::TaskTag callsite;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 30; i++) {
+        callsite = ATL_CALLSITE_TAG();
+        futures.push_back(pool.Push(callsite, []() {}));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    pool.Stop();
+    pool.Wait();
+    std::vector<atl::TagProfile> profiles = pool.GetProfile();
+    ASSERT_EQ(1u, profiles.size());
+    EXPECT_EQ(callsite, profiles[0].tag);
+    EXPECT_EQ(30u, profiles[0].count);
+    EXPECT_NE(std::string::npos, std::string(callsite.Name()).find("task_profile_test.cpp:"));
+}
+
+TEST(TaskProfile, JsonEscape) {
+    atl::TagProfile profile{atl::TaskTag("profile \"quoted\"\\"), 1, 2, 3, 4};
+    EXPECT_EQ("[{\"tag\":\"profile \\\"quoted\\\"\\\\\",\"count\":1,\"wait_ns\":2,\"wall_ns\":3,\"cpu_ns\":4}]",
+              atl::FormatProfileJson({profile}));
+}
+
+// 超过列宽的标签完整输出, 不截断也不丢掉后面的数值列
+TEST(TaskProfile, TextLongTag) {
+    std::string name = std::string(300, 'x') + ".end";
+    atl::TagProfile profile{atl::TaskTag(name.c_str()), 7, 2000000, 3000000, 4000000};
+    std::string text = atl::FormatProfileText({profile});
+    size_t row = text.find('\n') + 1;
+    EXPECT_EQ(0u, text.find("tag" + std::string(29, ' ') + " "));
+    EXPECT_EQ(row, text.find(name + " "));
+    EXPECT_NE(std::string::npos, text.find("7        2.000        3.000        4.000", row));
+    EXPECT_EQ('\n', text.back());
+}
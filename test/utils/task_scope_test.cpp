@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include "atl/utils/task_scope.h"
+
+namespace {
+
+void SpawnTree(atl::TaskScope& scope, std::atomic<int>& count, int depth) {
+    count++;
+    if (depth == 0) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        scope.Spawn([&scope, &count, depth]() { SpawnTree(scope, count, depth - 1); });
+    }
+}
+
+}
+
+TEST(TaskScope, Join) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    atl::TaskScope scope(pool);
+    std::atomic<int> count(0);
+    SpawnTree(scope, count, 10);
+    scope.Join();
+    EXPECT_EQ(2047, count.load());
+    EXPECT_EQ(0, scope.Pending());
+
+    // Join之后内存池被复用, 大的子任务单独占用一块
+    char payload[10000] = {1};
+    std::atomic<int> sum(0);
+    for (int i = 0; i < 100; i++) {
+        scope.Spawn([&sum, i]() { sum += i; });
+    }
+    scope.Spawn([&sum, payload]() { sum += payload[0]; });
+    scope.Join();
+    EXPECT_EQ(4951, sum.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(TaskScope, JoinOnWorker) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    // 只有一个工作线程时, 在工作线程上Join通过帮助执行子任务避免死锁
+    std::future<int> result = pool.Push([&pool]() {
+        atl::TaskScope scope(pool);
+        std::atomic<int> count(0);
+        SpawnTree(scope, count, 6);
+        scope.Join();
+        return count.load();
+    });
+    EXPECT_EQ(127, result.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(TaskScope, ExceptionCancelsSiblings) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    atl::TaskScope scope(pool);
+    std::atomic<int> executed(0);
+    std::atomic<bool> observed_cancel(false);
+    scope.Spawn([&scope, &observed_cancel]() {
+        for (int i = 0; i < 5000 && !scope.Token().IsCancellationRequested(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        observed_cancel = scope.IsCancellationRequested();
+    });
+    scope.Spawn([]() { throw std::runtime_error("failed"); });
+    for (int i = 0; i < 100; i++) {
+        scope.Spawn([&executed]() { executed++; });
+    }
+    EXPECT_THROW(scope.Join(), std::runtime_error);
+    EXPECT_TRUE(observed_cancel.load());
+    EXPECT_LT(executed.load(), 100);
+    EXPECT_TRUE(scope.IsCancellationRequested());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(TaskScope, DestructorWaits) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::atomic<int> count(0);
+    {
+        atl::TaskScope scope(pool);
+        for (int i = 0; i < 100; i++) {
+            scope.Spawn([&count]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                count++;
+            });
+        }
+        scope.Spawn([]() { throw std::runtime_error("ignored"); });
+    }
+    EXPECT_LE(count.load(), 100);
+    EXPECT_GT(count.load(), 0);
+    pool.Stop();
+    pool.Wait();
+}
@@ -255,3 +255,113 @@ TEST(ThreadPool2, StopInGrop2) {
     pool.Wait();
     EXPECT_EQ(count.load(), async_task_run_count);
 }
+
+TEST(ThreadPool2, PushCancelGroup) {
+    std::atomic<int> count(0);
+    std::promise<int> group_done;
+    std::future<int> group_future = group_done.get_future();
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+
+    atl::CancellationSource source;
+    source.Cancel();
+    atl::AsyncGroup* group = atl::ThreadPool2::CreateAsyncGroup([&count, &group_done]() {
+        group_done.set_value(count.load());
+    });
+    group->Push([&count]() { count.fetch_add(1); });
+    group->Push(source.Token(), [&count]() { count.fetch_add(1); });
+    group->Push(source.Token(), [&count]() { count.fetch_add(1); });
+    pool.Push(group);
+
+    EXPECT_EQ(1, group_future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ThreadPool2, PushCancelled) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+
+    atl::CancellationSource source;
+    source.Cancel();
+    std::future<int> future = pool.Push(source.Token(), []() -> int { return 1; });
+    EXPECT_THROW(future.get(), std::future_error);
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ThreadPool2, WorkerLocal) {
+    atl::ThreadPool2 pool;
+    pool.Start(3);
+    std::atomic<int> destroyed(0);
+    atl::WorkerLocal<int>& counters = pool.Local<int>(nullptr, [&destroyed](int& count) {
+        destroyed.fetch_add(count);
+    });
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 300; i++) {
+        futures.push_back(pool.Push([&pool, &counters]() {
+            (*counters.Get())++;
+            return pool.WorkerIndex();
+        }));
+    }
+    std::vector<int> per_shard(3, 0);
+    for (auto& future : futures) {
+        int index = future.get();
+        ASSERT_GE(index, 0);
+        ASSERT_LT(index, 3);
+        per_shard[index]++;
+    }
+    // 轮询分配, 每个分片的任务数相同
+    EXPECT_EQ(100, per_shard[0]);
+    EXPECT_EQ(100, per_shard[2]);
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(300, destroyed.load());
+}
+
+TEST(ThreadPool2, LazyStart) {
+    atl::ThreadPool2 pool;
+    atl::WorkerThreadOptions options;
+    options.lazy_start = true;
+    pool.SetWorkerThreadOptions(options);
+    pool.Start(3);
+    EXPECT_EQ(0, pool.GetStartupStats().started_workers);
+
+    // 只有收到任务的分片创建线程
+    std::promise<int> shard;
+    pool.Execute(1, [&pool, &shard]() { shard.set_value(pool.WorkerIndex()); });
+    EXPECT_EQ(1, shard.get_future().get());
+    EXPECT_EQ(1, pool.GetStartupStats().started_workers);
+    EXPECT_GE(pool.GetStartupStats().first_task_latency_ns, 0);
+    pool.Stop();
+    pool.Wait();
+}
+
+// 分片的工作线程内提交到本分片的任务排在已排队的任务之后
+TEST(ThreadPool2, ExecuteShardOrder) {
+    atl::ThreadPool2 pool;
+    pool.Start(2);
+    std::vector<int> order;
+    std::promise<void> started;
+    std::promise<void> gate;
+    std::promise<void> done;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    pool.Execute(0, [&pool, &order, &started, &done, gate_future]() {
+        started.set_value();
+        gate_future.wait();
+        order.push_back(0);
+        pool.Execute(0, [&order]() { order.push_back(2); });
+        pool.Execute(0, [&order, &done]() {
+            order.push_back(3);
+            done.set_value();
+        });
+    });
+    started.get_future().wait();
+    pool.Execute(0, [&order]() { order.push_back(1); });
+    gate.set_value();
+    done.get_future().wait();
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), order);
+    pool.Stop();
+    pool.Wait();
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <cstdint>
 #include "atl/utils/thread_pool.h"
 
 TEST(AsyncTaskCallable, ConstructorDefault) {
@@ -67,3 +68,14 @@ TEST(AsyncTaskCallable, MoveConstructor) {
     task.callable->CallFinishCallback();
     EXPECT_EQ(3, num);
 }
+
+TEST(AsyncTaskCallable, OverAlignedFunctor) {
+    struct alignas(32) Functor {
+        uintptr_t* address;
+        void operator()() { *address = reinterpret_cast<uintptr_t>(this); }
+    };
+    uintptr_t address = 1;
+    atl::AsyncTaskCallable task(Functor{&address}, []() {});
+    task.callable->CallAsyncFunction();
+    EXPECT_EQ(0u, address % 32);
+}
@@ -255,3 +255,533 @@ TEST(ThreadPool, StopInGrop2) {
     pool.Wait();
     EXPECT_EQ(count.load(), async_task_run_count);
 }
+
+// 在队列中被取消的任务不会执行任务函数, future收到broken_promise
+TEST(ThreadPool, PushCancelQueued) {
+    std::atomic<int> count(0);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    atl::ThreadPool pool;
+    pool.Start(1);
+    pool.Push([gate_future]() { gate_future.wait(); });
+
+    atl::CancellationSource source;
+    std::future<int> future = pool.Push(source.Token(), [&count]() -> int { return count.fetch_add(1); });
+    pool.Push(source.Token(), [&count]() { count.fetch_add(1); }, [&count]() { count.fetch_add(1); });
+    std::future<int> other = pool.Push([&count]() -> int { return count.fetch_add(1); });
+    source.Cancel();
+    gate.set_value();
+
+    EXPECT_EQ(0, other.get());
+    EXPECT_THROW(future.get(), std::future_error);
+    EXPECT_EQ(1, count.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 正在运行的任务可以轮询取消令牌
+TEST(ThreadPool, PushCancelRunning) {
+    std::atomic<bool> started(false);
+    atl::ThreadPool pool;
+    pool.Start(1);
+
+    atl::CancellationSource source;
+    atl::CancellationToken token = source.Token();
+    std::future<int> future = pool.Push(token, [&started, token]() -> int {
+        started.store(true);
+        int loops = 0;
+        while (!token.IsCancellationRequested()) {
+            loops++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return loops;
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    source.Cancel();
+    EXPECT_GE(future.get(), 0);
+    pool.Stop();
+    pool.Wait();
+}
+
+// 分组中部分任务被取消, 分组完成回调仍然会被调用
+TEST(ThreadPool, PushCancelGroup) {
+    std::atomic<int> count(0);
+    std::promise<int> group_done;
+    std::future<int> group_future = group_done.get_future();
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    atl::ThreadPool pool;
+    pool.Start(1);
+    pool.Push([gate_future]() { gate_future.wait(); });
+
+    atl::CancellationSource source;
+    atl::AsyncGroup* group = atl::ThreadPool::CreateAsyncGroup([&count, &group_done]() {
+        group_done.set_value(count.load());
+    });
+    group->Push([&count]() { count.fetch_add(1); });
+    group->Push(source.Token(), [&count]() { count.fetch_add(1); });
+    group->Push(source.Token(), [&count]() { count.fetch_add(1); }, [&count]() { count.fetch_add(1); });
+    group->Push([&count]() { count.fetch_add(1); }, [&count]() { count.fetch_add(1); });
+    pool.Push(group);
+    source.Cancel();
+    gate.set_value();
+
+    EXPECT_EQ(3, group_future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 出队时已过期的任务不执行, 改为调用过期回调
+TEST(ThreadPool, PushExpired) {
+    std::atomic<int> count(0);
+    std::atomic<int> expired(0);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    atl::ThreadPool pool;
+    pool.Start(1);
+    pool.Push([gate_future]() { gate_future.wait(); });
+
+    auto now = atl::TaskOptions::Clock::now();
+    atl::TaskOptions stale(now + std::chrono::milliseconds(5), [&expired]() { expired.fetch_add(1); });
+    atl::TaskOptions fresh(now + std::chrono::hours(1), [&expired]() { expired.fetch_add(1); });
+    std::future<void> stale_future = pool.Push(stale, [&count]() { count.fetch_add(1); });
+    pool.Push(stale, [&count]() { count.fetch_add(1); }, [&count]() { count.fetch_add(1); });
+    std::future<void> fresh_future = pool.Push(fresh, [&count]() { count.fetch_add(1); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    gate.set_value();
+
+    fresh_future.get();
+    EXPECT_THROW(stale_future.get(), std::future_error);
+    EXPECT_EQ(1, count.load());
+    EXPECT_EQ(2, expired.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 过期的分组任务仍然计入分组的完成数量
+TEST(ThreadPool, PushExpiredGroup) {
+    std::atomic<int> count(0);
+    std::promise<int> group_done;
+    std::future<int> group_future = group_done.get_future();
+    atl::ThreadPool pool;
+    pool.Start(1);
+
+    atl::AsyncGroup* group = atl::ThreadPool::CreateAsyncGroup([&count, &group_done]() {
+        group_done.set_value(count.load());
+    });
+    atl::TaskOptions expired(atl::TaskOptions::Clock::now() - std::chrono::milliseconds(1));
+    group->Push([&count]() { count.fetch_add(1); });
+    group->Push(expired, [&count]() { count.fetch_add(1); });
+    pool.Push(group);
+
+    EXPECT_EQ(1, group_future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ThreadPool, EarliestDeadlineFirst) {
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    atl::ThreadPool pool;
+    pool.SetSchedulingMode(atl::SchedulingMode::kEarliestDeadlineFirst);
+    pool.Start(1);
+    pool.Push([gate_future]() { gate_future.wait(); });
+
+    auto record = [&mtx, &order](int value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        order.push_back(value);
+    };
+    auto now = atl::TaskOptions::Clock::now() + std::chrono::hours(1);
+    pool.Push(std::bind(record, 5));
+    pool.Push(atl::TaskOptions(now + std::chrono::seconds(3)), std::bind(record, 3), [](){});
+    pool.Push(atl::TaskOptions(now + std::chrono::seconds(1)), std::bind(record, 1), [](){});
+    pool.Push(atl::TaskOptions(now + std::chrono::seconds(2)), std::bind(record, 2), [](){});
+    std::future<void> last = pool.Push(std::bind(record, 6));
+    pool.Push(atl::TaskOptions(now + std::chrono::seconds(3)), std::bind(record, 4), [](){});
+    gate.set_value();
+
+    last.get();
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5, 6}), order);
+}
+
+// 工作线程内提交的任务放入本线程的next_slot, 由同一个线程执行
+TEST(ThreadPool, PushFromWorkerRunsLocally) {
+    std::atomic<bool> blocker_started(false);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    atl::ThreadPool pool;
+    pool.Start(2);
+    pool.Push([gate_future, &blocker_started]() {
+        blocker_started.store(true);
+        gate_future.wait();
+    });
+    while (!blocker_started.load()) {
+        std::this_thread::yield();
+    }
+
+    std::promise<std::thread::id> child_id;
+    std::future<std::thread::id> child_future = child_id.get_future();
+    std::future<std::thread::id> parent_future = pool.Push([&pool, &child_id]() {
+        pool.Push([&child_id]() { child_id.set_value(std::this_thread::get_id()); });
+        return std::this_thread::get_id();
+    });
+    EXPECT_EQ(parent_future.get(), child_future.get());
+    gate.set_value();
+    pool.Stop();
+    pool.Wait();
+}
+
+// 工作线程等待自己提交的任务时, 空闲的工作线程会窃取该任务
+TEST(ThreadPool, PushFromWorkerStolen) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::future<int> future = pool.Push([&pool]() -> int {
+        std::future<int> child = pool.Push([]() -> int { return 1; });
+        return child.get() + 1;
+    });
+    EXPECT_EQ(2, future.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ThreadPool, PushFromWorkerChain) {
+    std::atomic<int> count(0);
+    std::promise<void> done;
+    std::future<void> done_future = done.get_future();
+    int chain_length = 1000;
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::function<void()> step = [&]() {
+        if (count.fetch_add(1) + 1 == chain_length) {
+            done.set_value();
+            return;
+        }
+        pool.Push(step, [](){});
+        pool.Push([&count]() { count.fetch_add(0); }, [](){});
+    };
+    pool.Push(step, [](){});
+    done_future.get();
+    EXPECT_EQ(chain_length, count.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 工作线程内提交的任务最新的先执行, 其余按提交顺序执行; ordered任务进入全局队列按提交顺序执行
+TEST(ThreadPool, PushFromWorkerOrder) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    for (bool ordered : {false, true}) {
+        std::vector<int> order;
+        std::promise<void> done;
+        std::future<void> done_future = done.get_future();
+        pool.Push([&pool, &order, &done, ordered]() {
+            atl::TaskOptions options;
+            options.ordered = ordered;
+            for (int i = 0; i < 3; i++) {
+                pool.Push(options, [&order, &done, i]() {
+                    order.push_back(i);
+                    if (order.size() == 3) {
+                        done.set_value();
+                    }
+                }, [](){});
+            }
+        });
+        done_future.get();
+        EXPECT_EQ(ordered ? std::vector<int>({0, 1, 2}) : std::vector<int>({2, 0, 1}), order);
+    }
+    pool.Stop();
+    pool.Wait();
+}
+
+// 每个工作线程一份对象, 在工作线程退出前由该线程销毁
+TEST(ThreadPool, WorkerLocal) {
+    atl::ThreadPool pool;
+    struct Buffer {
+        std::thread::id owner = std::this_thread::get_id();
+        int uses = 0;
+    };
+    std::atomic<int> created(0);
+    std::atomic<int> destroyed(0);
+    std::atomic<int> uses(0);
+    std::atomic<bool> same_thread(true);
+    atl::WorkerLocal<Buffer>& buffers = pool.Local<Buffer>(
+        [&created]() {
+            created.fetch_add(1);
+            return std::unique_ptr<Buffer>(new Buffer());
+        },
+        [&destroyed, &uses, &same_thread](Buffer& buffer) {
+            if (buffer.owner != std::this_thread::get_id()) {
+                same_thread = false;
+            }
+            uses.fetch_add(buffer.uses);
+            destroyed.fetch_add(1);
+        });
+    pool.Start(4);
+    EXPECT_EQ(-1, pool.WorkerIndex());
+    EXPECT_EQ(nullptr, buffers.Get());
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; i++) {
+        futures.push_back(pool.Push([&pool, &buffers]() {
+            buffers.Get()->uses++;
+            return pool.WorkerIndex();
+        }));
+    }
+    for (auto& future : futures) {
+        int index = future.get();
+        EXPECT_GE(index, 0);
+        EXPECT_LT(index, 4);
+    }
+    pool.Stop();
+    pool.Wait();
+    EXPECT_LE(created.load(), 4);
+    EXPECT_EQ(created.load(), destroyed.load());
+    EXPECT_EQ(1000, uses.load());
+    EXPECT_TRUE(same_thread.load());
+}
+
+// 排队时间持续过长时丢弃已排队的低优先级任务, 拒绝新提交的低优先级任务, 空闲后恢复
+TEST(ThreadPool, AdmissionControl) {
+    atl::ThreadPool pool;
+    pool.EnableAdmissionControl(std::chrono::milliseconds(1), std::chrono::milliseconds(10));
+    pool.Start(1);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    pool.Push([gate_future]() { gate_future.wait(); });
+
+    std::atomic<int> normal(0);
+    std::atomic<int> low(0);
+    std::atomic<int> rejected(0);
+    atl::TaskOptions low_options;
+    low_options.priority = atl::TaskPriority::kLow;
+    low_options.rejected_callback = [&rejected]() { rejected.fetch_add(1); };
+
+    std::vector<std::future<void>> normal_futures;
+    for (int i = 0; i < 5; i++) {
+        normal_futures.push_back(pool.Push([&normal]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            normal.fetch_add(1);
+        }));
+    }
+    std::vector<std::future<void>> low_futures;
+    for (int i = 0; i < 5; i++) {
+        low_futures.push_back(pool.Push(low_options, [&low]() { low.fetch_add(1); }));
+    }
+    // 过载期间在工作线程内提交的低优先级任务在提交时被拒绝
+    std::future<bool> overloaded = pool.Push([&pool, &low_options, &low]() {
+        bool result = pool.GetAdmissionStats().overloaded;
+        pool.Push(low_options, [&low]() { low.fetch_add(1); }, []() {});
+        return result;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gate.set_value();
+
+    for (auto& future : normal_futures) {
+        future.get();
+    }
+    for (auto& future : low_futures) {
+        EXPECT_THROW(future.get(), std::future_error);
+    }
+    EXPECT_TRUE(overloaded.get());
+    EXPECT_EQ(5, normal.load());
+    EXPECT_EQ(0, low.load());
+    EXPECT_EQ(6, rejected.load());
+    atl::AdmissionController::Stats stats = pool.GetAdmissionStats();
+    EXPECT_EQ(5u, stats.shed);
+    EXPECT_EQ(1u, stats.rejected);
+
+    // 工作线程空闲后退出过载状态
+    for (int i = 0; i < 100 && pool.GetAdmissionStats().overloaded; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(pool.GetAdmissionStats().overloaded);
+    pool.Push(low_options, [&low]() { low.fetch_add(1); }).get();
+    EXPECT_EQ(1, low.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 按租户公平调度: 大量排队的租户不会饿死其他租户, 租户之间按权重出队
+TEST(ThreadPool, WeightedFair) {
+    atl::ThreadPool pool;
+    pool.SetSchedulingMode(atl::SchedulingMode::kWeightedFair);
+    pool.SetTenantWeight(2, 2);
+    pool.Start(1);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    std::future<void> blocker = pool.Push([gate_future]() { gate_future.wait(); });
+
+    std::mutex mtx;
+    std::vector<uint32_t> order;
+    std::vector<std::future<void>> futures;
+    for (uint32_t tenant : {1u, 2u}) {
+        for (int i = 0; i < 30; i++) {
+            atl::TaskOptions options;
+            options.tenant = tenant;
+            futures.push_back(pool.Push(options, [&mtx, &order, tenant]() {
+                std::lock_guard<std::mutex> lock(mtx);
+                order.push_back(tenant);
+            }));
+        }
+    }
+    gate.set_value();
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    ASSERT_EQ(60u, order.size());
+    int tenant1 = 0;
+    for (int i = 0; i < 30; i++) {
+        tenant1 += order[i] == 1 ? 1 : 0;
+    }
+    EXPECT_EQ(10, tenant1);
+
+    std::vector<atl::TenantStats> stats = pool.GetTenantStats();
+    ASSERT_EQ(3u, stats.size());
+    EXPECT_EQ(1u, stats[1].tenant);
+    EXPECT_EQ(30u, stats[1].executed);
+    EXPECT_EQ(2u, stats[2].weight);
+    EXPECT_EQ(30u, stats[2].executed);
+    EXPECT_EQ(0u, stats[2].queued);
+    EXPECT_GT(stats[1].wait_ns, 0u);
+    EXPECT_GT(stats[1].cpu_ns, 0u);
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(ThreadPool, PushBlocking) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::promise<void> gate;
+    std::shared_future<void> gate_future = gate.get_future().share();
+    // 阻塞任务不占用唯一的工作线程
+    std::future<int> blocking = pool.PushBlocking([gate_future]() {
+        gate_future.wait();
+        return 1;
+    });
+    std::future<int> compute = pool.Push([]() { return 2; });
+    EXPECT_EQ(2, compute.get());
+    gate.set_value();
+    EXPECT_EQ(1, blocking.get());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 只有一个工作线程时, 阻塞等待后提交的任务也不会死锁, 补偿线程在离开阻塞区后转为空闲
+TEST(ThreadPool, BlockingRegion) {
+    atl::ThreadPool pool;
+    pool.Start(1);
+    std::promise<int> produced;
+    std::future<int> produced_future = produced.get_future();
+    std::future<int> consumer = pool.Push([&produced_future]() {
+        atl::BlockingRegion region;
+        {
+            atl::BlockingRegion nested;
+        }
+        return produced_future.get();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pool.Push([&produced]() { produced.set_value(7); });
+    EXPECT_EQ(7, consumer.get());
+
+    for (int i = 0; i < 100 && pool.ActiveSpareCount() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(0, pool.ActiveSpareCount());
+
+    // 空闲的补偿线程被复用
+    std::promise<int> second;
+    std::future<int> second_future = second.get_future();
+    std::future<int> waiter = pool.Push([&second_future]() {
+        atl::BlockingRegion region;
+        return second_future.get();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    pool.Push([&second]() { second.set_value(8); });
+    EXPECT_EQ(8, waiter.get());
+
+    // 不在工作线程上时不做任何事
+    {
+        atl::BlockingRegion region;
+    }
+    pool.Stop();
+    pool.Wait();
+}
+
+// 休眠的补偿线程不计为休眠的工作线程, 不会阻止延迟启动时按需创建工作线程
+TEST(ThreadPool, LazyStartWithBlockingRegion) {
+    atl::ThreadPool pool;
+    atl::WorkerThreadOptions options;
+    options.lazy_start = true;
+    pool.SetWorkerThreadOptions(options);
+    pool.Start(2);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::promise<void> blocked;
+    std::future<void> blocker = pool.Push([released, &blocked]() {
+        atl::BlockingRegion region;
+        blocked.set_value();
+        released.wait();
+    });
+    blocked.get_future().wait();
+    EXPECT_EQ(1, pool.GetStartupStats().started_workers);
+    // 等补偿线程找不到任务进入休眠
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    std::future<void> second = pool.Push([released]() { released.wait(); });
+    for (int i = 0; i < 1000 && pool.GetStartupStats().started_workers < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(2, pool.GetStartupStats().started_workers);
+    release.set_value();
+    blocker.get();
+    second.get();
+    pool.Stop();
+    pool.Wait();
+}
+
+// 延迟启动时Start不创建线程, 有排队的任务时逐个创建, 不超过pool_size
+TEST(ThreadPool, LazyStart) {
+    atl::ThreadPool pool;
+    atl::WorkerThreadOptions options;
+    options.lazy_start = true;
+    options.stack_size = 256 * 1024;
+    options.name = "atl-lazy";
+    pool.SetWorkerThreadOptions(options);
+    pool.Start(4);
+    EXPECT_EQ(0, pool.GetStartupStats().started_workers);
+    EXPECT_EQ(-1, pool.GetStartupStats().first_task_latency_ns);
+
+    std::future<std::string> name = pool.Push([]() {
+        char buffer[16] = {0};
+        pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+        return std::string(buffer);
+    });
+    EXPECT_EQ("atl-lazy-0", name.get());
+    EXPECT_EQ(1, pool.GetStartupStats().started_workers);
+    EXPECT_GE(pool.GetStartupStats().first_task_latency_ns, 0);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 8; i++) {
+        futures.push_back(pool.Push([released]() { released.wait(); }));
+    }
+    for (int i = 0; i < 1000 && pool.GetStartupStats().started_workers < 4; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(4, pool.GetStartupStats().started_workers);
+    release.set_value();
+    for (auto& future : futures) {
+        future.get();
+    }
+    pool.Stop();
+    pool.Wait();
+    EXPECT_EQ(4, pool.GetStartupStats().started_workers);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+#include "atl/utils/timer_queue.h"
+
+TEST(TimerQueue, Schedule) {
+    atl::TimerQueue queue;
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    auto record = [&mtx, &order](int value) {
+        std::lock_guard<std::mutex> lock(mtx);
+        order.push_back(value);
+    };
+    queue.Schedule(std::chrono::milliseconds(30), [&record, &done]() { record(3); done.set_value(); });
+    queue.Schedule(std::chrono::milliseconds(10), std::bind(record, 1));
+    queue.Schedule(std::chrono::milliseconds(20), std::bind(record, 2));
+    future.get();
+    EXPECT_EQ(std::vector<int>({1, 2, 3}), order);
+    EXPECT_EQ(0u, queue.Size());
+}
+
+TEST(TimerQueue, Cancel) {
+    atl::TimerQueue queue;
+    std::atomic<int> count(0);
+    uint64_t id = queue.Schedule(std::chrono::milliseconds(10), [&count]() { count.fetch_add(1); });
+    EXPECT_EQ(1u, queue.Size());
+    EXPECT_TRUE(queue.Cancel(id));
+    EXPECT_FALSE(queue.Cancel(id));
+    EXPECT_EQ(0u, queue.Size());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(0, count.load());
+}
+
+TEST(TimerQueue, Default) {
+    std::promise<void> done;
+    std::future<void> future = done.get_future();
+    atl::TimerQueue::Default().Schedule(std::chrono::milliseconds(1), [&done]() { done.set_value(); });
+    EXPECT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds(5)));
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/thread_pool2.h"
+
+TEST(Watchdog, TaskTag) {
+    atl::TaskTag first("watchdog.test.tag");
+    atl::TaskTag second("watchdog.test.tag");
+    atl::TaskTag other("watchdog.test.other");
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_STREQ("watchdog.test.tag", first.Name());
+    EXPECT_EQ(0u, atl::TaskTag().Id());
+    EXPECT_STREQ("", atl::TaskTag().Name());
+}
+
+// 同一个时钟周期内开始的同标签任务编码不同, 后一个卡住时仍会被报告
+TEST(Watchdog, StampSequence) {
+    atl::Watchdog watchdog(std::chrono::milliseconds(100), nullptr);
+    atl::TaskTag tag("watchdog.test.sequence");
+    uint64_t first = watchdog.Stamp(tag, 1);
+    uint64_t second = watchdog.Stamp(tag, 2);
+    EXPECT_NE(0u, first);
+    EXPECT_NE(first, second);
+    EXPECT_NE(0u, watchdog.Stamp(atl::TaskTag(), 256));
+    atl::WorkerState state = watchdog.Decode(3, second, 5);
+    EXPECT_TRUE(state.running);
+    EXPECT_EQ(tag, state.tag);
+    EXPECT_EQ(std::chrono::milliseconds(0), state.running_time);
+    EXPECT_EQ(5u, state.local_queue);
+}
+
+TEST(Watchdog, ReportStuckTask) {
+    static const atl::TaskTag kStuckTag("watchdog.test.stuck");
+    std::mutex mtx;
+    std::vector<atl::WorkerState> reports;
+    atl::ThreadPool pool;
+    pool.EnableWatchdog(std::chrono::milliseconds(20), [&mtx, &reports](const atl::WorkerState& worker) {
+        std::lock_guard<std::mutex> lock(mtx);
+        reports.push_back(worker);
+    });
+    pool.Start(2);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    atl::TaskOptions options;
+    options.tag = kStuckTag;
+    std::future<void> stuck = pool.Push(options, [released]() { released.wait(); });
+    // 快速完成的任务不会被报告
+    for (int i = 0; i < 100; i++) {
+        pool.Push([]() {}).get();
+    }
+    for (int i = 0; i < 1000; i++) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!reports.empty()) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string dump = pool.DumpState();
+    EXPECT_NE(std::string::npos, dump.find("running [watchdog.test.stuck]")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("global queue: 0")) << dump;
+    atl::PoolState state = pool.GetState();
+    ASSERT_EQ(2u, state.workers.size());
+    EXPECT_EQ(1, state.workers[0].running + state.workers[1].running);
+
+    // 同一个任务只报告一次
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+    stuck.get();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        ASSERT_EQ(1u, reports.size());
+        EXPECT_EQ(kStuckTag, reports[0].tag);
+        EXPECT_TRUE(reports[0].running);
+        EXPECT_GE(reports[0].running_time.count(), 20);
+    }
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(Watchdog, ThreadPool2) {
+    static const atl::TaskTag kShardTag("watchdog.test.shard");
+    std::promise<atl::WorkerState> report;
+    std::once_flag once;
+    atl::ThreadPool2 pool;
+    pool.EnableWatchdog(std::chrono::milliseconds(10), [&report, &once](const atl::WorkerState& worker) {
+        std::call_once(once, [&report, &worker]() { report.set_value(worker); });
+    });
+    pool.Start(3);
+    atl::TaskOptions options;
+    options.tag = kShardTag;
+    std::promise<void> release;
+    std::future<void> released = release.get_future();
+    pool.Push(options, [&released]() { released.wait(); }, []() {});
+    atl::WorkerState worker = report.get_future().get();
+    EXPECT_EQ(kShardTag, worker.tag);
+    EXPECT_GE(worker.index, 0);
+    EXPECT_LT(worker.index, 3);
+    EXPECT_EQ(3u, pool.GetState().workers.size());
+    release.set_value();
+    pool.Stop();
+    pool.Wait();
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "atl/utils/thread_pool.h"
+#include "atl/utils/when_all.h"
+
+TEST(WhenAll, Results) {
+    atl::ThreadPool pool;
+    pool.Start(4);
+    std::vector<std::function<int()>> functions;
+    for (int i = 0; i < 100; i++) {
+        functions.push_back([i]() {
+            std::this_thread::sleep_for(std::chrono::microseconds((100 - i) * 10));
+            return i * i;
+        });
+    }
+    std::vector<int> results = atl::WhenAll<int>(pool, std::move(functions)).get();
+    ASSERT_EQ(100u, results.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i * i, results[i]);
+    }
+
+    // 回调在最后完成的任务上执行
+    std::promise<size_t> size;
+    atl::WhenAll<int>(pool, {[]() { return 1; }, []() { return 2; }},
+                      [&size, &pool](std::vector<int>&& values, std::exception_ptr error) {
+        EXPECT_FALSE(error);
+        EXPECT_GE(pool.WorkerIndex(), 0);
+        size.set_value(values.size());
+    });
+    EXPECT_EQ(2u, size.get_future().get());
+
+    EXPECT_TRUE(atl::WhenAll<int>(pool, {}).get().empty());
+    pool.Stop();
+    pool.Wait();
+}
+
+TEST(WhenAll, Exception) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::atomic<int> executed(0);
+    std::future<std::vector<int>> future = atl::WhenAll<int>(pool, {
+        [&executed]() { executed++; return 1; },
+        [&executed]() -> int { executed++; throw std::runtime_error("failed"); },
+        [&executed]() { executed++; return 3; },
+    });
+    EXPECT_THROW(future.get(), std::runtime_error);
+    EXPECT_EQ(3, executed.load());
+    pool.Stop();
+    pool.Wait();
+}
+
+// 对冲请求: 快的副本胜出后, 慢的副本通过令牌提前返回, 排队中的副本不再执行
+TEST(WhenAny, Hedged) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    std::atomic<bool> slow_cancelled(false);
+    std::atomic<int> queued_executed(0);
+    std::future<atl::WhenAnyResult<std::string>> future = atl::WhenAny<std::string>(pool, {
+        [&slow_cancelled](const atl::CancellationToken& token) {
+            for (int i = 0; i < 5000 && !token.IsCancellationRequested(); i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            slow_cancelled = token.IsCancellationRequested();
+            return std::string("slow");
+        },
+        [](const atl::CancellationToken&) -> std::string {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return "fast";
+        },
+        [&queued_executed](const atl::CancellationToken&) {
+            queued_executed++;
+            return std::string("queued");
+        },
+    });
+    atl::WhenAnyResult<std::string> result = future.get();
+    EXPECT_EQ(1u, result.index);
+    EXPECT_EQ("fast", result.value);
+    pool.Stop();
+    pool.Wait();
+    EXPECT_TRUE(slow_cancelled.load());
+    EXPECT_EQ(0, queued_executed.load());
+}
+
+TEST(WhenAny, Exception) {
+    atl::ThreadPool pool;
+    pool.Start(2);
+    // 抛出异常的函数不会胜出
+    std::future<atl::WhenAnyResult<int>> first = atl::WhenAny<int>(pool, {
+        [](const atl::CancellationToken&) -> int { throw std::runtime_error("failed"); },
+        [](const atl::CancellationToken&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return 2;
+        },
+    });
+    EXPECT_EQ(2, first.get().value);
+
+    std::future<atl::WhenAnyResult<int>> all_failed = atl::WhenAny<int>(pool, {
+        [](const atl::CancellationToken&) -> int { throw std::runtime_error("failed"); },
+        [](const atl::CancellationToken&) -> int { throw std::logic_error("failed"); },
+    });
+    EXPECT_ANY_THROW(all_failed.get());
+    EXPECT_THROW(atl::WhenAny<int>(pool, {}).get(), std::invalid_argument);
+    pool.Stop();
+    pool.Wait();
+}